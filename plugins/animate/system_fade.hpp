@@ -26,8 +26,9 @@ class wf_system_fade
         render_hook = [=] ()
         { render(); };
 
-        output->render->add_effect(&damage_hook, wf::OUTPUT_EFFECT_PRE);
-        output->render->add_effect(&render_hook, wf::OUTPUT_EFFECT_OVERLAY);
+        output->render->add_effect(&damage_hook, wf::OUTPUT_EFFECT_PRE, "fade");
+        output->render->add_effect(&render_hook, wf::OUTPUT_EFFECT_OVERLAY,
+            "fade");
         output->render->set_redraw_always();
         this->progression.animate(1, 0);
     }
@@ -52,6 +52,7 @@ wf_blur_base::wf_blur_base(wf::output_t *output, std::string name)
 {
     this->output = output;
     this->algorithm_name = name;
+    this->fb[0].owner = this->fb[1].owner = "blur";
 
     this->saturation_opt.load_option("blur/saturation");
     this->offset_opt.load_option("blur/" + algorithm_name + "_offset");
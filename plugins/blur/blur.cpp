@@ -53,17 +53,19 @@ class wf_blur_transformer : public wf::view_transformer_t
         return wf::TRANSFORMER_BLUR;
     }
 
+    /* Blurring samples the target framebuffer around the damage, which holds
+     * the previous output if the buffer is cached. */
+    bool is_output_cacheable() override
+    {
+        return false;
+    }
+
     /* Render without blending */
     void direct_render(wf::texture_t src_tex, wlr_box src_box,
         const wf::region_t& damage, const wf::framebuffer_t& target_fb)
     {
         OpenGL::render_begin(target_fb);
-        for (auto& rect : damage)
-        {
-            target_fb.logic_scissor(wlr_box_from_pixman_box(rect));
-            OpenGL::render_texture(src_tex, target_fb, src_box);
-        }
-
+        OpenGL::render_texture(src_tex, target_fb, src_box, damage);
         OpenGL::render_end();
     }
 
@@ -211,7 +213,7 @@ class wayfire_blur : public wf::plugin_interface_t
     void update_blur_region()
     {
         blur_region.clear();
-        auto views = output->workspace->get_views_in_layer(wf::ALL_LAYERS);
+        auto views = output->workspace->get_views_in_layer_span(wf::ALL_LAYERS);
 
         for (auto& view : views)
         {
@@ -250,6 +252,7 @@ class wayfire_blur : public wf::plugin_interface_t
     {
         grab_interface->name = "blur";
         grab_interface->capabilities = 0;
+        saved_pixels.owner = "blur";
 
         blur_method_changed = [=] ()
         {
@@ -333,7 +336,8 @@ class wayfire_blur : public wf::plugin_interface_t
             output->render->damage(expand_region(
                 damage & this->blur_region, fb.scale));
         };
-        output->render->add_effect(&frame_pre_paint, wf::OUTPUT_EFFECT_DAMAGE);
+        output->render->add_effect(&frame_pre_paint, wf::OUTPUT_EFFECT_DAMAGE,
+            "blur");
 
         /* workspace_stream_pre is called before rendering each frame
          * when rendering a workspace. It gives us a chance to pad
@@ -37,6 +37,9 @@ static void cairo_surface_upload_to_texture(
     GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_RED));
     GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA,
         buffer.width, buffer.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, src));
+    OpenGL::record_texture_memory(buffer.tex,
+        (size_t)buffer.width * buffer.height * 4,
+        buffer.owner.empty() ? "cairo texture" : buffer.owner);
 }
 
 namespace wf
@@ -214,7 +217,8 @@ struct cairo_text_t
     {
         wf::cairo_text_t ct;
         /* note: we "borrow" the texture from what was supplied (if any) */
-        ct.tex.tex = tex.tex;
+        ct.tex.tex   = tex.tex;
+        ct.tex.owner = tex.owner;
         auto ret = ct.render_text(text, par);
         if (tex.tex == (GLuint) - 1)
         {
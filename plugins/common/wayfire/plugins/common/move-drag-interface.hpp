@@ -11,6 +11,7 @@
 #include <wayfire/util/duration.hpp>
 #include <wayfire/util/log.hpp>
 #include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
 
 
 namespace wf
@@ -220,6 +221,19 @@ class scale_around_grab_t : public wf::view_transformer_t
 
         OpenGL::render_end();
     }
+
+    bool get_affine_transform(wf::geometry_t view, glm::mat4& transform,
+        glm::vec4& color) override
+    {
+        // Same as render_with_damage(): stretch the view to its bounding box
+        auto bbox = get_bounding_box(view, view);
+        transform = glm::translate(glm::mat4(1.0), glm::vec3(bbox.x, bbox.y, 0));
+        transform = glm::scale(transform, glm::vec3(
+            1.0 * bbox.width / view.width, 1.0 * bbox.height / view.height, 1));
+        transform = glm::translate(transform, glm::vec3(-view.x, -view.y, 0));
+        color     = glm::vec4(1.0);
+        return true;
+    }
 };
 
 static const std::string move_drag_transformer = "move-drag-transformer";
@@ -272,8 +286,9 @@ class output_data_t : public custom_data_t
   public:
     output_data_t(wf::output_t *output, std::vector<dragged_view_t> views)
     {
-        output->render->add_effect(&damage_overlay, OUTPUT_EFFECT_PRE);
-        output->render->add_effect(&render_overlay, OUTPUT_EFFECT_OVERLAY);
+        output->render->add_effect(&damage_overlay, OUTPUT_EFFECT_PRE, "move-drag");
+        output->render->add_effect(&render_overlay, OUTPUT_EFFECT_OVERLAY,
+            "move-drag");
 
         this->output = output;
         this->views  = views;
@@ -52,7 +52,8 @@ class preview_indication_view_t : public wf::color_rect_view_t
         animation.alpha.set(0, 1);
 
         pre_paint = [=] () { update_animation(); };
-        get_output()->render->add_effect(&pre_paint, wf::OUTPUT_EFFECT_PRE);
+        get_output()->render->add_effect(&pre_paint, wf::OUTPUT_EFFECT_PRE,
+            "preview-indication");
 
         set_color(base_color);
         set_border_color(base_border);
@@ -1,5 +1,6 @@
 #pragma once
 #include <wayfire/opengl.hpp>
+#include <string>
 
 namespace wf
 {
@@ -9,6 +10,10 @@ struct simple_texture_t
     int width  = 0;
     int height = 0;
 
+    /* The owner of the texture, used to report the GPU memory usage.
+     * See OpenGL::record_texture_memory() */
+    std::string owner;
+
     /**
      * Destroy the GL texture.
      * This will call OpenGL::render_begin()/end() internally.
@@ -23,6 +28,7 @@ struct simple_texture_t
         OpenGL::render_begin();
         GL_CALL(glDeleteTextures(1, &tex));
         OpenGL::render_end();
+        OpenGL::forget_texture_memory(tex);
         this->tex = -1;
     }
 
@@ -38,7 +44,7 @@ struct simple_texture_t
     simple_texture_t& operator =(const simple_texture_t&) = delete;
 
     simple_texture_t(simple_texture_t && o) noexcept : tex(o.tex), width(o.width),
-        height(o.height)
+        height(o.height), owner(std::move(o.owner))
     {
         o.tex = (GLuint) - 1;
     }
@@ -55,6 +61,7 @@ struct simple_texture_t
         tex    = o.tex;
         width  = o.width;
         height = o.height;
+        owner  = std::move(o.owner);
         o.tex  = (GLuint) - 1;
 
         return *this;
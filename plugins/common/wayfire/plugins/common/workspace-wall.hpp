@@ -1,6 +1,9 @@
 #pragma once
 
 
+#include <algorithm>
+#include <cmath>
+#include <optional>
 #include <glm/gtc/matrix_transform.hpp>
 #include "workspace-stream-sharing.hpp"
 
@@ -15,7 +18,18 @@ namespace wf
 struct wall_frame_event_t : public signal_data_t
 {
     const wf::framebuffer_t& target;
-    wall_frame_event_t(const wf::framebuffer_t& t) : target(t)
+
+    /**
+     * The parts of the target where listeners draw something different than
+     * in the last frame, in the coordinate system of the target's geometry.
+     * It covers the whole target by default, so that anything drawn by
+     * listeners is repainted. Listeners which do not draw on the target may
+     * clear it.
+     */
+    wf::region_t damage;
+
+    wall_frame_event_t(const wf::framebuffer_t& t) :
+        target(t), damage(t.geometry)
     {}
 };
 
@@ -105,7 +119,7 @@ class workspace_wall_t : public wf::signal_provider_t
      */
     void render_wall(const wf::framebuffer_t& fb, wf::geometry_t geometry)
     {
-        update_streams();
+        update_streams(get_stream_scale(geometry));
 
         OpenGL::render_begin(fb);
         fb.logic_scissor(geometry);
@@ -129,6 +143,7 @@ class workspace_wall_t : public wf::signal_provider_t
 
         wall_frame_event_t data{fb};
         this->emit_signal("frame", &data);
+        this->frame_listener_damage = std::move(data.damage);
     }
 
     /**
@@ -141,6 +156,7 @@ class workspace_wall_t : public wf::signal_provider_t
         {
             this->output->render->set_renderer(on_render);
             render_hook_set = true;
+            last_render_state.reset();
         }
     }
 
@@ -219,14 +235,36 @@ class workspace_wall_t : public wf::signal_provider_t
     std::vector<std::vector<glm::vec4>> render_colors;
 
     /** Update or start visible streams */
-    void update_streams()
+    void update_streams(float scale)
     {
         for (auto& ws : get_visible_workspaces(viewport))
         {
-            streams->update(ws);
+            streams->update(ws, scale);
         }
     }
 
+    /**
+     * Calculate the resolution at which workspaces need to be rendered, so
+     * that they have at least as many pixels as their image on the screen.
+     *
+     * The scale is rounded up to multiples of STREAM_SCALE_STEP, so that the
+     * stream buffers are not reallocated on every frame of a zoom animation.
+     */
+    static constexpr float STREAM_SCALE_STEP = 1.0 / 8;
+    float get_stream_scale(const wf::geometry_t& target) const
+    {
+        if ((viewport.width <= 0) || (viewport.height <= 0))
+        {
+            return 1.0;
+        }
+
+        double scale = std::max(target.width * 1.0 / viewport.width,
+            target.height * 1.0 / viewport.height);
+        scale = std::ceil(scale / STREAM_SCALE_STEP) * STREAM_SCALE_STEP;
+
+        return std::clamp(scale, (double)STREAM_SCALE_STEP, 1.0);
+    }
+
     /**
      * Get a list of workspaces visible in the viewport.
      */
@@ -291,10 +329,106 @@ class workspace_wall_t : public wf::signal_provider_t
         return translation * scaling;
     }
 
+    /** The parameters used for the last frame rendered as output renderer. */
+    struct render_state_t
+    {
+        wf::geometry_t viewport;
+        int gap_size;
+        glm::vec4 background_color;
+        std::vector<std::vector<glm::vec4>> render_colors;
+
+        bool operator ==(const render_state_t& other) const
+        {
+            return viewport == other.viewport && gap_size == other.gap_size &&
+                   background_color == other.background_color &&
+                   render_colors == other.render_colors;
+        }
+    };
+
+    std::optional<render_state_t> last_render_state;
+
+    /** The damage reported by the listeners of the last frame event. */
+    wf::region_t frame_listener_damage;
+
+    /**
+     * Map a box from the workspace wall coordinate system to the target
+     * rectangle on the screen, rounding outwards.
+     */
+    wf::geometry_t wall_to_target(const wf::geometry_t& box,
+        const wf::geometry_t& target) const
+    {
+        const double scale_x = target.width * 1.0 / viewport.width;
+        const double scale_y = target.height * 1.0 / viewport.height;
+
+        int x1 = std::floor(target.x + (box.x - viewport.x) * scale_x);
+        int y1 = std::floor(target.y + (box.y - viewport.y) * scale_y);
+        int x2 = std::ceil(target.x + (box.x + box.width - viewport.x) * scale_x);
+        int y2 = std::ceil(target.y + (box.y + box.height - viewport.y) * scale_y);
+
+        return {x1, y1, x2 - x1, y2 - y1};
+    }
+
+    /**
+     * When rendering as the output renderer, calculate which parts of the
+     * output will change in the next frame: the damaged parts of the visible
+     * workspaces, at their position on the screen. If any of the wall
+     * parameters has changed since the last frame, the whole output has to be
+     * repainted and nothing is returned.
+     */
+    std::optional<wf::region_t> get_output_damage(const wf::geometry_t& target)
+    {
+        render_state_t state{viewport, gap_size,
+            glm::vec4{background_color.r, background_color.g,
+                background_color.b, background_color.a},
+            render_colors};
+
+        if (!last_render_state || !(*last_render_state == state) ||
+            (viewport.width <= 0) || (viewport.height <= 0))
+        {
+            last_render_state = std::move(state);
+            return {};
+        }
+
+        wf::region_t damage;
+        auto scheduled = output->render->get_scheduled_damage();
+        for (auto& ws : get_visible_workspaces(this->viewport))
+        {
+            auto ws_box   = output->render->get_ws_box(ws);
+            auto wall_box = get_workspace_rectangle(ws);
+            for (const auto& rect : scheduled & ws_box)
+            {
+                auto box = wlr_box_from_pixman_box(rect);
+                box.x += wall_box.x - ws_box.x;
+                box.y += wall_box.y - ws_box.y;
+                damage |= wall_to_target(box, target);
+            }
+        }
+
+        return damage;
+    }
+
+    void render_output_frame(const wf::framebuffer_t& target)
+    {
+        /* Frame listeners may change the wall parameters for the next frame,
+         * so the damage is calculated before rendering. What the listeners
+         * draw on top of the wall is known only afterwards. */
+        auto geometry = this->output->get_relative_geometry();
+        auto damage   = get_output_damage(geometry);
+        render_wall(target, geometry);
+
+        /* Listeners may also have stopped the output renderer, in which case
+         * the hook calling us no longer exists. */
+        if (damage && render_hook_set)
+        {
+            *damage |= frame_listener_damage;
+            output->render->add_renderer_damage(*damage & geometry);
+        }
+    }
+
     bool render_hook_set = false;
     wf::render_hook_t on_render = [=] (const wf::framebuffer_t& target)
     {
-        render_wall(target, this->output->get_relative_geometry());
+        render_output_frame(target);
     };
 
     void resize_colors()
@@ -18,6 +18,7 @@ wf_cube_background_cubemap::~wf_cube_background_cubemap()
     OpenGL::render_begin();
     program.free_resources();
     GL_CALL(glDeleteTextures(1, &tex));
+    OpenGL::forget_texture_memory(tex);
     GL_CALL(glDeleteBuffers(1, &vbo_cube_vertices));
     GL_CALL(glDeleteBuffers(1, &ibo_cube_indices));
     OpenGL::render_end();
@@ -55,6 +56,7 @@ void wf_cube_background_cubemap::reload_texture()
             last_background_image.c_str());
 
         GL_CALL(glDeleteTextures(1, &tex));
+        OpenGL::forget_texture_memory(tex);
         GL_CALL(glDeleteBuffers(1, &vbo_cube_vertices));
         GL_CALL(glDeleteBuffers(1, &ibo_cube_indices));
         tex = -1;
@@ -61,6 +61,7 @@ void wf_cube_background_skydome::reload_texture()
         LOGE("Failed to load skydome image from \"%s\".",
             last_background_image.c_str());
         GL_CALL(glDeleteTextures(1, &tex));
+        OpenGL::forget_texture_memory(tex);
         tex = -1;
     }
 
@@ -13,7 +13,9 @@ namespace decor
 {
 button_t::button_t(const decoration_theme_t& t, std::function<void()> damage) :
     theme(t), damage_callback(damage)
-{}
+{
+    button_texture.owner = "decoration";
+}
 
 void button_t::set_button_type(button_type_t type)
 {
@@ -72,6 +72,7 @@ class simple_decoration_surface : public wf::surface_interface_t,
     {
         this->view = view;
         view->connect_signal("title-changed", &title_set);
+        title_texture.tex.owner = "decoration";
 
         // make sure to hide frame if the view is fullscreen
         update_decoration_size();
@@ -26,6 +26,7 @@ class crossfade_t : public wf::view_2D
         // Create a copy of the view contents
         original_buffer.geometry = view->get_wm_geometry();
         original_buffer.scale    = view->get_output()->handle->scale;
+        original_buffer.owner    = "grid crossfade";
 
         auto w = original_buffer.scale * original_buffer.geometry.width;
         auto h = original_buffer.scale * original_buffer.geometry.height;
@@ -121,7 +122,7 @@ class grid_animation_t : public wf::custom_data_t
         this->type   = type;
         this->animation = wf::geometry_animation_t{duration};
 
-        output->render->add_effect(&pre_hook, wf::OUTPUT_EFFECT_PRE);
+        output->render->add_effect(&pre_hook, wf::OUTPUT_EFFECT_PRE, "grid");
         output->connect_signal("view-disappeared", &unmapped);
     }
 
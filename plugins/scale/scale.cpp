@@ -1456,8 +1456,8 @@ class wayfire_scale : public wf::plugin_interface_t
             return;
         }
 
-        output->render->add_effect(&post_hook, wf::OUTPUT_EFFECT_POST);
-        output->render->add_effect(&pre_hook, wf::OUTPUT_EFFECT_PRE);
+        output->render->add_effect(&post_hook, wf::OUTPUT_EFFECT_POST, "scale");
+        output->render->add_effect(&pre_hook, wf::OUTPUT_EFFECT_PRE, "scale");
         output->render->schedule_redraw();
         hook_set = true;
     }
@@ -6,6 +6,8 @@
 #include <string>
 #include <list>
 #include <algorithm>
+#include <array>
+#include <optional>
 
 namespace wf
 {
@@ -125,6 +127,19 @@ class scale_transformer_t : public wf::view_2D
         }
     }
 
+    /**
+     * The output is cached while the 2D parameters stay the same. Overlays
+     * damage the view from their pre-hooks when they change.
+     */
+    bool is_output_cacheable() override
+    {
+        std::array<float, 6> params = {scale_x, scale_y,
+            translation_x, translation_y, angle, alpha};
+        bool unchanged = (cached_params == params);
+        cached_params = params;
+        return unchanged;
+    }
+
     /**
      * Call pre-render hooks.
      *
@@ -303,6 +318,8 @@ class scale_transformer_t : public wf::view_2D
     }
 
     wf::geometry_t last_view_box = {0, 0, 0, 0};
+    /* 2D parameters at the last call of is_output_cacheable() */
+    std::optional<std::array<float, 6>> cached_params;
     wf::wl_idle_call idle_call;
 };
 }
@@ -671,8 +671,11 @@ class wayfire_expo : public wf::plugin_interface_t
         }
     }
 
-    wf::signal_connection_t on_frame = {[=] (wf::signal_data_t*)
+    wf::signal_connection_t on_frame = {[=] (wf::signal_data_t *data)
         {
+            /* Nothing is drawn on top of the wall */
+            static_cast<wf::wall_frame_event_t*>(data)->damage.clear();
+
             if (zoom_animation.running())
             {
                 output->render->schedule_redraw();
@@ -367,7 +367,7 @@ class wayfire_idle_singleton : public wf::singleton_plugin_t<wayfire_idle>
             if (!hook_set)
             {
                 output->render->add_effect(
-                    &screensaver_frame, wf::OUTPUT_EFFECT_PRE);
+                    &screensaver_frame, wf::OUTPUT_EFFECT_PRE, "idle");
                 hook_set = true;
             }
         } else if (state == CUBE_SCREENSAVER_DISABLED)
@@ -106,8 +106,11 @@ class vswipe : public wf::plugin_interface_t
         wall->connect_signal("frame", &this->on_frame);
     }
 
-    wf::signal_connection_t on_frame = {[=] (wf::signal_data_t*)
+    wf::signal_connection_t on_frame = {[=] (wf::signal_data_t *data)
         {
+            /* Nothing is drawn on top of the wall */
+            static_cast<wf::wall_frame_event_t*>(data)->damage.clear();
+
             if (!smooth_delta.running() && !state.swiping)
             {
                 finalize_and_exit();
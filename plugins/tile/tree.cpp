@@ -299,6 +299,13 @@ struct view_node_t::scale_transformer_t : public wf::view_2D
         this->translation_x = box.x - scaled_x;
         this->translation_y = box.y - scaled_y;
     }
+
+    bool get_affine_transform(wf::geometry_t view, glm::mat4& transform,
+        glm::vec4& color) override
+    {
+        get_2D_transform(transform, color);
+        return true;
+    }
 };
 
 /**
@@ -176,6 +176,8 @@ class workspace_switch_t
     bool running = false;
     wf::signal_connection_t on_frame = [=] (wf::signal_data_t *data)
     {
+        /* The overlay view changes every frame, so the whole target keeps
+         * being reported as damaged. */
         render_frame(static_cast<wall_frame_event_t*>(data)->target);
     };
 
@@ -598,7 +598,7 @@ class wf_wobbly : public wf::view_transformer_t
 
         sig->output->render->rem_effect(&pre_hook);
         view->get_output()->render->add_effect(&pre_hook,
-            wf::OUTPUT_EFFECT_PRE);
+            wf::OUTPUT_EFFECT_PRE, "wobbly");
 
         on_workspace_changed.disconnect();
         view->get_output()->connect_signal("workspace-changed",
@@ -638,7 +638,8 @@ class wf_wobbly : public wf::view_transformer_t
         last_frame = wf::get_current_time();
 
         pre_hook = [=] () { update_model(); };
-        view->get_output()->render->add_effect(&pre_hook, wf::OUTPUT_EFFECT_PRE);
+        view->get_output()->render->add_effect(&pre_hook, wf::OUTPUT_EFFECT_PRE,
+            "wobbly");
         view->get_output()->connect_signal("workspace-changed",
             &on_workspace_changed);
 
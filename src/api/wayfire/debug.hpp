@@ -34,13 +34,19 @@ namespace log
 enum class logging_category : size_t
 {
     // Transactions - general
-    TXN  = 0,
+    TXN    = 0,
     // Transactions - view instructions
-    TXNV = 1,
+    TXNV   = 1,
     // Transactions - instructions lifetime (pending, ready, timeout, etc.)
-    TXNI = 2,
+    TXNI   = 2,
     // Wlroots messages
-    WLR  = 3,
+    WLR    = 3,
+    // Repaint cycle timings
+    RENDER = 4,
+    // GPU memory usage
+    GPUMEM = 5,
+    // Pointer motion coalescing
+    INPUT  = 6,
     TOTAL,
 };
 
@@ -8,6 +8,7 @@ namespace image_io
 {
 /* Load the image from the given file, binding it to the given GL texture target
  * Bind the texture before you call this function
+ * The texture is recorded with OpenGL::record_texture_memory()
  * Guaranteed: doesn't change any GL state except pixel packing */
 bool load_from_file(std::string name, GLuint target);
 
@@ -0,0 +1,352 @@
+#ifndef WF_SAFE_VECTOR_HPP
+#define WF_SAFE_VECTOR_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "reverse.hpp"
+
+/* A list with the same guarantees as safe_list_t, i.e any element can be
+ * added or removed at any given time, even while iterating over the list.
+ *
+ * In contrast to safe_list_t, the elements are stored contiguously, without
+ * a heap allocation for each element, and no idle callback is needed:
+ *
+ * - Removed elements are destroyed immediately, but their slots are only
+ *   compacted at the next safe point, i.e once no iteration over the list is
+ *   in progress anymore.
+ * - Elements added while the list is iterated are kept aside until the next
+ *   safe point, so that the elements being iterated never move. Iterations
+ *   which are already in progress do not visit them, nested iterations visit
+ *   them after all other elements.
+ *
+ * The generation of the list is incremented whenever the elements are moved,
+ * i.e on compaction and on insertion in the middle of the list. */
+namespace wf
+{
+template<class T>
+class safe_vector_t
+{
+  public:
+    enum insert_place_t
+    {
+        INSERT_BEFORE,
+        INSERT_AFTER,
+        INSERT_NONE,
+    };
+
+    safe_vector_t() = default;
+
+    /* Copy the not-erased elements from other */
+    safe_vector_t(const safe_vector_t& other)
+    {
+        *this = other;
+    }
+
+    safe_vector_t& operator =(const safe_vector_t& other)
+    {
+        if (this != &other)
+        {
+            clear();
+            other.for_each([&] (T& el)
+            {
+                this->push_back(el);
+            });
+        }
+
+        return *this;
+    }
+
+    safe_vector_t(safe_vector_t&& other) = default;
+    safe_vector_t& operator =(safe_vector_t&& other) = default;
+
+    T& back()
+    {
+        for (auto& el : wf::reverse(pending))
+        {
+            if (el.value && (el.position == APPEND))
+            {
+                return *el.value;
+            }
+        }
+
+        for (auto& el : wf::reverse(elements))
+        {
+            if (el)
+            {
+                return *el;
+            }
+        }
+
+        throw std::out_of_range("back() called on an empty list!");
+    }
+
+    size_t size() const
+    {
+        return live;
+    }
+
+    /* Get the number of times the elements have been moved in memory */
+    uint64_t get_generation() const
+    {
+        return generation;
+    }
+
+    /* Push back by copying */
+    void push_back(T value)
+    {
+        emplace_back(std::move(value));
+    }
+
+    /* Push back by moving */
+    void emplace_back(T&& value)
+    {
+        insert_at_index(std::move(value), APPEND);
+    }
+
+    /* Insert the given value at a position in the list, determined by the
+     * check function. The value is inserted at the first position that
+     * check indicates, or at the end of the list otherwise */
+    template<class Check>
+    void emplace_at(T&& value, Check check)
+    {
+        /* If no place found, insert at the end */
+        size_t index = APPEND;
+        {
+            iteration_t guard{this};
+            for (size_t i = 0; i < elements.size(); i++)
+            {
+                /* Skip empty elements */
+                if (!elements[i])
+                {
+                    continue;
+                }
+
+                auto place = check(*elements[i]);
+                if (place != INSERT_NONE)
+                {
+                    index = (place == INSERT_BEFORE) ? i : i + 1;
+                    break;
+                }
+            }
+        }
+
+        insert_at_index(std::move(value), index);
+    }
+
+    template<class Check>
+    void insert_at(T value, Check check)
+    {
+        emplace_at(std::move(value), check);
+    }
+
+    /* Call func for each non-erased element of the list */
+    template<class Func>
+    void for_each(Func func) const
+    {
+        iteration_t guard{this};
+
+        /* Go through all elements currently in the list. Elements are
+         * accessed by index, because elements can be added to pending. */
+        size_t count = elements.size();
+        size_t pending_count = pending.size();
+        for (size_t i = 0; i < count; i++)
+        {
+            if (elements[i])
+            {
+                func(*elements[i]);
+            }
+        }
+
+        for (size_t i = 0; i < pending_count; i++)
+        {
+            if (pending[i].value)
+            {
+                func(*pending[i].value);
+            }
+        }
+    }
+
+    /* Call func for each non-erased element of the list in reversed order */
+    template<class Func>
+    void for_each_reverse(Func func) const
+    {
+        iteration_t guard{this};
+
+        size_t count = elements.size();
+        for (size_t i = pending.size(); i > 0; i--)
+        {
+            if (pending[i - 1].value)
+            {
+                func(*pending[i - 1].value);
+            }
+        }
+
+        for (size_t i = count; i > 0; i--)
+        {
+            if (elements[i - 1])
+            {
+                func(*elements[i - 1]);
+            }
+        }
+    }
+
+    /* Safely remove all elements equal to value */
+    void remove_all(const T& value)
+    {
+        /* value may refer to an element of the list, so copy it */
+        remove_if([=] (const T& el) { return el == value; });
+    }
+
+    /* Remove all elements from the list */
+    void clear()
+    {
+        remove_if([] (const T&) { return true; });
+    }
+
+    /* Remove all elements satisfying a given condition.
+     * The elements are destroyed immediately, and their slots are compacted at
+     * the next safe point. */
+    template<class Predicate>
+    void remove_if(Predicate predicate)
+    {
+        /* Destructors of the removed elements may modify the list, too */
+        iteration_t guard{this};
+        auto try_remove = [&] (std::optional<T>& el)
+        {
+            if (el && predicate(std::as_const(*el)))
+            {
+                /* First reset the element in the list, and then free
+                 * resources, in case the destructor accesses the list */
+                std::optional<T> removed;
+                removed.swap(el);
+                --live;
+                dirty = true;
+            }
+        };
+
+        for (size_t i = 0; i < elements.size(); i++)
+        {
+            try_remove(elements[i]);
+        }
+
+        for (size_t i = 0; i < pending.size(); i++)
+        {
+            try_remove(pending[i].value);
+        }
+    }
+
+  private:
+    static constexpr size_t APPEND = SIZE_MAX;
+
+    struct pending_t
+    {
+        std::optional<T> value;
+        /* The index of the element before which the value is inserted */
+        size_t position;
+    };
+
+    /* The storage is modified during iteration, which is const */
+    mutable std::vector<std::optional<T>> elements;
+    mutable std::deque<pending_t> pending;
+    mutable size_t live = 0;
+    mutable bool dirty  = false;
+    mutable int iterating = 0;
+    mutable uint64_t generation = 0;
+
+    /** Tracks the iterations in progress and compacts after the last one */
+    struct iteration_t
+    {
+        const safe_vector_t *list;
+        iteration_t(const safe_vector_t *list) : list(list)
+        {
+            ++list->iterating;
+        }
+
+        ~iteration_t()
+        {
+            if (--list->iterating == 0)
+            {
+                list->compact();
+            }
+        }
+    };
+
+    void insert_at_index(T&& value, size_t index)
+    {
+        ++live;
+        if (iterating)
+        {
+            pending.push_back({std::move(value), index});
+            dirty = true;
+        } else if ((index == APPEND) || (index >= elements.size()))
+        {
+            elements.emplace_back(std::move(value));
+        } else
+        {
+            elements.emplace(elements.begin() + index, std::move(value));
+            ++generation;
+        }
+    }
+
+    /* Remove the slots of erased elements and merge the pending elements,
+     * at a safe point */
+    void compact() const
+    {
+        if (!dirty)
+        {
+            return;
+        }
+
+        dirty = false;
+        ++generation;
+
+        if (pending.empty())
+        {
+            elements.erase(std::remove_if(elements.begin(), elements.end(),
+                [] (const std::optional<T>& el) { return !el; }), elements.end());
+            return;
+        }
+
+        /* Insertions at the same position keep their order */
+        std::stable_sort(pending.begin(), pending.end(),
+            [] (const pending_t& a, const pending_t& b)
+        {
+            return a.position < b.position;
+        });
+
+        std::vector<std::optional<T>> merged;
+        merged.reserve(live);
+        auto next = pending.begin();
+        for (size_t i = 0; i <= elements.size(); i++)
+        {
+            while ((next != pending.end()) &&
+                   ((next->position == i) ||
+                    ((i == elements.size()) && (next->position > i))))
+            {
+                if (next->value)
+                {
+                    merged.emplace_back(std::move(next->value));
+                }
+
+                ++next;
+            }
+
+            if ((i < elements.size()) && elements[i])
+            {
+                merged.emplace_back(std::move(elements[i]));
+            }
+        }
+
+        elements = std::move(merged);
+        pending.clear();
+    }
+};
+}
+
+#endif /* end of include guard: WF_SAFE_VECTOR_HPP */
@@ -25,6 +25,63 @@ struct signal_data_t
 using signal_callback_t = std::function<void (signal_data_t*)>;
 class signal_provider_t;
 
+/**
+ * An interned signal name.
+ *
+ * Connecting to and emitting signals by name requires hashing the name and
+ * looking it up. Signal ids are registered once, after which emitting a
+ * signal with them needs neither string allocations nor hashing. Typically,
+ * they are static objects:
+ *
+ * static const wf::signal_id_t geometry_changed{"geometry-changed"};
+ * view->emit_signal(geometry_changed, &data);
+ *
+ * Ids created with the same name are equal, so a signal connected to by name
+ * is also emitted by id, and vice versa.
+ */
+class signal_id_t
+{
+  public:
+    /** Get the id of the signal with the given name, registering the name if
+     * necessary. */
+    explicit signal_id_t(const std::string& name);
+
+    /** Get the name of the signal. */
+    const std::string& get_name() const;
+
+    /** Get the value of the id, which is unique for each signal name. */
+    uint32_t get_value() const
+    {
+        return value;
+    }
+
+    bool operator ==(const signal_id_t& other) const
+    {
+        return value == other.value;
+    }
+
+    bool operator !=(const signal_id_t& other) const
+    {
+        return value != other.value;
+    }
+
+  private:
+    uint32_t value;
+};
+
+/**
+ * A signal id which also carries the type of the signal data, so that
+ * emitting the signal with other data does not compile.
+ */
+template<class SignalData>
+struct typed_signal_id_t
+{
+    explicit typed_signal_id_t(const std::string& name) : id(name)
+    {}
+
+    signal_id_t id;
+};
+
 /**
  * Provides an interface to connect to signal providers.
  *
@@ -74,6 +131,16 @@ class signal_provider_t
   public:
     /** Register a connection to be called when the given signal is emitted. */
     void connect_signal(std::string name, signal_connection_t *callback);
+    /** Register a connection to be called when the given signal is emitted. */
+    void connect_signal(const signal_id_t& id, signal_connection_t *callback);
+
+    template<class SignalData>
+    void connect_signal(const typed_signal_id_t<SignalData>& id,
+        signal_connection_t *callback)
+    {
+        connect_signal(id.id, callback);
+    }
+
     /** Unregister a connection. */
     void disconnect_signal(signal_connection_t *callback);
 
@@ -88,8 +155,21 @@ class signal_provider_t
      */
     void disconnect_signal(std::string name, signal_callback_t *callback);
 
-    /** Emit the given signal. No type checking for data is required */
+    /**
+     * Emit the given signal. No type checking for data is required.
+     *
+     * Kept for compatibility, emitting with a signal_id_t is cheaper.
+     */
     void emit_signal(std::string name, signal_data_t *data);
+    /** Emit the given signal. No type checking for data is required */
+    void emit_signal(const signal_id_t& id, signal_data_t *data);
+
+    /** Emit the given signal with data of the type of the signal. */
+    template<class SignalData>
+    void emit_signal(const typed_signal_id_t<SignalData>& id, SignalData *data)
+    {
+        emit_signal(id.id, data);
+    }
 
     virtual ~signal_provider_t();
 
@@ -122,9 +202,32 @@ class custom_data_t
     custom_data_t& operator =(const custom_data_t& other) = default;
 };
 
+/**
+ * Register a data slot with the given name, or get the existing slot.
+ * Used by get_data_slot().
+ */
+uint32_t _register_data_slot(const std::string& name);
+
+/**
+ * Get the index of the data slot of the type T. Slots are process-wide, each
+ * object stores the data of the type T in this slot, so that it can be found
+ * without hashing the name of the type.
+ */
+template<class T>
+uint32_t get_data_slot()
+{
+    static const uint32_t slot = _register_data_slot(typeid(T).name());
+    return slot;
+}
+
 /**
  * A base class for "objects". Objects provide signals and ways for plugins to
  * store custom data about the object.
+ *
+ * Custom data can be stored either by type or by name. Data stored by type is
+ * kept in the slot of the type (see get_data_slot()), so that retrieving it
+ * is a direct lookup. Storing data by name is slower, and intended for
+ * data which has to be distinguished by more than the type.
  */
 class object_base_t : public signal_provider_t
 {
@@ -135,6 +238,26 @@ class object_base_t : public signal_provider_t
     /** Get the ID of the object. Each object has a unique ID */
     uint32_t get_id() const;
 
+    /**
+     * Retrieve custom data stored for the type T. If no such data exists,
+     * then it is created with the default constructor.
+     *
+     * REQUIRES a default constructor
+     * If your type doesn't have one, use store_data + get_data
+     */
+    template<class T>
+    nonstd::observer_ptr<T> get_data_safe()
+    {
+        auto data = get_data<T>();
+        if (data)
+        {
+            return data;
+        }
+
+        store_data<T>(std::make_unique<T>());
+        return get_data<T>();
+    }
+
     /**
      * Retrieve custom data stored with the given name. If no such data exists,
      * then it is created with the default constructor.
@@ -143,8 +266,7 @@ class object_base_t : public signal_provider_t
      * If your type doesn't have one, use store_data + get_data
      */
     template<class T>
-    nonstd::observer_ptr<T> get_data_safe(
-        std::string name = typeid(T).name())
+    nonstd::observer_ptr<T> get_data_safe(std::string name)
     {
         auto data = get_data<T>(name);
         if (data)
@@ -158,28 +280,42 @@ class object_base_t : public signal_provider_t
         }
     }
 
+    /* Retrieve custom data stored for the type T. If no such data exists,
+     * NULL is returned */
+    template<class T>
+    nonstd::observer_ptr<T> get_data()
+    {
+        return nonstd::make_observer(
+            dynamic_cast<T*>(_fetch_slot(get_data_slot<T>())));
+    }
+
     /* Retrieve custom data stored with the given name. If no such
      * data exists, NULL is returned */
     template<class T>
-    nonstd::observer_ptr<T> get_data(
-        std::string name = typeid(T).name())
+    nonstd::observer_ptr<T> get_data(std::string name)
     {
         return nonstd::make_observer(dynamic_cast<T*>(_fetch_data(name)));
     }
 
+    /* Assigns the given data to the type T */
+    template<class T>
+    void store_data(std::unique_ptr<T> stored_data)
+    {
+        _store_slot(std::move(stored_data), get_data_slot<T>());
+    }
+
     /* Assigns the given data to the given name */
     template<class T>
-    void store_data(std::unique_ptr<T> stored_data,
-        std::string name = typeid(T).name())
+    void store_data(std::unique_ptr<T> stored_data, std::string name)
     {
         _store_data(std::move(stored_data), name);
     }
 
-    /* Returns true if there is saved data under the given name */
+    /* Returns true if there is saved data for the type T */
     template<class T>
     bool has_data()
     {
-        return has_data(typeid(T).name());
+        return _fetch_slot(get_data_slot<T>()) != nullptr;
     }
 
     /** @return true if there is saved data with the given name */
@@ -192,13 +328,21 @@ class object_base_t : public signal_provider_t
     template<class T>
     void erase_data()
     {
-        erase_data(typeid(T).name());
+        delete _fetch_erase_slot(get_data_slot<T>());
+    }
+
+    /* Erase the saved data for the type T from the store and return the
+     * pointer */
+    template<class T>
+    std::unique_ptr<T> release_data()
+    {
+        auto stored = _fetch_erase_slot(get_data_slot<T>());
+        return std::unique_ptr<T>(dynamic_cast<T*>(stored));
     }
 
     /* Erase the saved data from the store and return the pointer */
     template<class T>
-    std::unique_ptr<T> release_data(
-        std::string name = typeid(T).name())
+    std::unique_ptr<T> release_data(std::string name)
     {
         if (!has_data(name))
         {
@@ -233,6 +377,13 @@ class object_base_t : public signal_provider_t
     /** Store the given data under the given name */
     void _store_data(std::unique_ptr<custom_data_t> data, std::string name);
 
+    /** Get the data in the given slot, or nullptr */
+    custom_data_t *_fetch_slot(uint32_t slot);
+    /** Get the data in the given slot and release the pointer */
+    custom_data_t *_fetch_erase_slot(uint32_t slot);
+    /** Store the given data in the given slot */
+    void _store_slot(std::unique_ptr<custom_data_t> data, uint32_t slot);
+
     class obase_impl;
     std::unique_ptr<obase_impl> obase_priv;
 };
@@ -8,6 +8,9 @@
 #include <wayfire/nonstd/wlroots.hpp>
 
 #include <wayfire/geometry.hpp>
+#include <wayfire/region.hpp>
+#include <string>
+#include <vector>
 
 #define GLM_FORCE_RADIANS
 #include <glm/mat4x4.hpp>
@@ -41,6 +44,10 @@ struct framebuffer_base_t
     GLuint tex = -1, fb = -1;
     int32_t viewport_width = 0, viewport_height = 0;
 
+    /* The owner of the buffer, used to report the GPU memory usage.
+     * See OpenGL::record_texture_memory() */
+    std::string owner;
+
     framebuffer_base_t() = default;
     virtual ~framebuffer_base_t() = default;
     framebuffer_base_t(framebuffer_base_t&& other);
@@ -52,7 +59,9 @@ struct framebuffer_base_t
      * OpenGL::render_begin() and OpenGL::render_end() */
 
     /* will invalidate texture contents if width or height changes.
-     * If tex and/or fb haven't been set, it creates them
+     * If tex and fb haven't been set, they are taken from a pool of
+     * framebuffers, which is also used to exchange them when the size changes.
+     * If only one of them hasn't been set, it is created.
      * Return true if texture was created/invalidated */
     bool allocate(int width, int height);
 
@@ -63,7 +72,8 @@ struct framebuffer_base_t
      * coordinate space */
     void scissor(wlr_box box) const;
 
-    /* Will destroy the texture and framebuffer
+    /* Will destroy the texture and framebuffer, or return them to the pool
+     * if they were taken from it.
      * Warning: will destroy tex/fb even if they have been allocated outside of
      * allocate() */
     void release();
@@ -187,6 +197,17 @@ void render_begin(int32_t viewport_width, int32_t viewport_height, uint32_t fb);
  * render_end() must be called for each render_begin() */
 void render_end();
 
+/**
+ * When the core renders, the OpenGL helpers keep track of the GL state they
+ * set, and skip calls which would not change it. Plugin code (hooks,
+ * transformers, custom surfaces, workspace stream signals) runs with the
+ * tracking suspended, so plugins may change the GL state in any way.
+ *
+ * Discard the tracked state. This is needed only if the state is changed
+ * outside of plugin code while the core renders.
+ */
+void invalidate_state();
+
 /* Clear the currently bound framebuffer with the given color */
 void clear(wf::color_t color, uint32_t mask = GL_COLOR_BUFFER_BIT);
 
@@ -267,6 +288,32 @@ void render_texture(wf::texture_t texture,
     glm::vec4 color = glm::vec4(1.f),
     uint32_t bits   = 0);
 
+/**
+ * Render the parts of a textured quad which are inside the given region.
+ *
+ * The quad is clipped to each rectangle of the region and all pieces are
+ * submitted in a single draw call. This is equivalent to, but much cheaper
+ * than, calling render_texture() after logic_scissor() for each rectangle.
+ * The scissor test is disabled afterwards.
+ *
+ * @param texture   The texture to render.
+ * @param fb        The framebuffer to render onto.
+ *                  It should have been already bound.
+ * @param geometry  The geometry of the quad to render, in the same coordinate
+ *                    system as the framebuffer geometry.
+ * @param damage    The region to render, in the same coordinate system as
+ *                    the framebuffer geometry.
+ * @param color     A color multiplier for each channel of the texture.
+ * @param bits      A bitwise OR of texture_rendering_flags_t. In this variant,
+ *                    TEX_GEOMETRY and RENDER_FLAG_CACHED are ignored.
+ */
+void render_texture(wf::texture_t texture,
+    const wf::framebuffer_t& framebuffer,
+    const wf::geometry_t& geometry,
+    const wf::region_t& damage,
+    glm::vec4 color = glm::vec4(1.f),
+    uint32_t bits   = 0);
+
 /**
  * Render the textured rectangle again.
  *
@@ -301,6 +348,44 @@ GLuint compile_program(std::string vertex_source, std::string frag_source);
  */
 void render_rectangle(wf::geometry_t box, wf::color_t color, glm::mat4 matrix);
 
+/**
+ * Record that the given texture uses the given amount of GPU memory.
+ * Recording the same texture again replaces the previous record.
+ *
+ * Textures of wf::framebuffer_base_t are recorded automatically. Other
+ * textures should be recorded by whoever allocates their storage, so that
+ * the GPU memory usage can be inspected with get_gpu_memory_usage().
+ *
+ * @param tex The texture to record.
+ * @param bytes The size of the texture storage.
+ * @param owner A description of the owner of the texture, for ex. the
+ *   plugin name, "view 42 snapshot" or "output DP-1 workspace stream".
+ */
+void record_texture_memory(GLuint tex, size_t bytes, const std::string& owner);
+
+/** Remove the record of a texture, for ex. because it has been deleted. */
+void forget_texture_memory(GLuint tex);
+
+struct gpu_memory_usage_t
+{
+    std::string owner;
+    /* The total size of the textures of the owner */
+    size_t bytes    = 0;
+    size_t textures = 0;
+};
+
+/**
+ * Get the GPU memory used by the recorded textures, summed up per owner and
+ * sorted from the largest consumer to the smallest.
+ */
+std::vector<gpu_memory_usage_t> get_gpu_memory_usage();
+
+/** Get the total GPU memory used by the recorded textures. */
+size_t get_total_gpu_memory();
+
+/** Log the total recorded GPU memory usage and its largest consumers. */
+void log_gpu_memory_usage();
+
 /**
  * An OpenGL program for rendering texture_t.
  * It contains multiple programs for the different texture types.
@@ -357,6 +442,29 @@ class program_t
     /** @return The program ID for the given texture type, or 0 on failure */
     int get_program_id(wf::texture_type_t type);
 
+    /**
+     * A handle to a uniform of the program.
+     *
+     * Handles are resolved once for all texture types, and they stay valid
+     * when the program is recompiled. Setting uniforms via handles avoids
+     * looking up the uniform by name on each call.
+     */
+    struct uniform_t
+    {
+        int id = -1;
+    };
+
+    /** A handle to a vertex attribute of the program, see uniform_t. */
+    struct attrib_t
+    {
+        int id = -1;
+    };
+
+    /** @return A handle to the uniform with the given name. */
+    uniform_t get_uniform(const std::string& name);
+    /** @return A handle to the vertex attribute with the given name. */
+    attrib_t get_attrib(const std::string& name);
+
     /** Set the given uniform for the currently used program. */
     void uniform1i(const std::string& name, int value);
     /** Set the given uniform for the currently used program. */
@@ -370,6 +478,19 @@ class program_t
     /** Set the given uniform for the currently used program. */
     void uniformMatrix4f(const std::string& name, const glm::mat4& value);
 
+    /** Set the given uniform for the currently used program. */
+    void uniform1i(uniform_t uniform, int value);
+    /** Set the given uniform for the currently used program. */
+    void uniform1f(uniform_t uniform, float value);
+    /** Set the given uniform for the currently used program. */
+    void uniform2f(uniform_t uniform, float x, float y);
+    /** Set the given uniform for the currently used program. */
+    void uniform3f(uniform_t uniform, float x, float y, float z);
+    /** Set the given uniform for the currently used program. */
+    void uniform4f(uniform_t uniform, const glm::vec4& value);
+    /** Set the given uniform for the currently used program. */
+    void uniformMatrix4f(uniform_t uniform, const glm::mat4& value);
+
     /*
      * Set the attribute pointer and active the attribute.
      *
@@ -388,6 +509,31 @@ class program_t
      */
     void attrib_divisor(const std::string& attrib, int divisor);
 
+    /** Same as attrib_pointer() with a name, but takes a resolved handle. */
+    void attrib_pointer(attrib_t attrib,
+        int size, int stride, const void *ptr, GLenum type = GL_FLOAT);
+
+    /** Same as attrib_divisor() with a name, but takes a resolved handle. */
+    void attrib_divisor(attrib_t attrib, int divisor);
+
+    /**
+     * Source the given attributes from a persistent vertex buffer, which
+     * contains the corners of the unit square (0, 0), (1, 0), (1, 1), (0, 1),
+     * in the order expected by GL_TRIANGLE_FAN.
+     *
+     * The setup is kept in a vertex array object, so no vertex data is
+     * uploaded when drawing. It cannot be mixed with attrib_pointer() and
+     * attrib_divisor(): these switch back to the default vertex array, so
+     * the unit quad is no longer used until use_unit_quad() is called again.
+     *
+     * @param position The attribute which receives the corner coordinates.
+     * @param uv A second attribute which receives the same coordinates, for
+     *   ex. texture coordinates.
+     */
+    void use_unit_quad(attrib_t position, attrib_t uv);
+    /** Same as use_unit_quad() with two attributes, but sets only one. */
+    void use_unit_quad(attrib_t position);
+
     /**
      * Set the active texture, and modify the builtin Y-inversion uniforms.
      * Will not work with custom programs.
@@ -395,8 +541,8 @@ class program_t
     void set_active_texture(const wf::texture_t& texture);
 
     /**
-     * Deactivate the vertex attributes activated by attrib_pointer and
-     * attrib_divisor, and reset the active OpenGL program.
+     * Deactivate the vertex attributes activated by attrib_pointer,
+     * attrib_divisor and use_unit_quad, and reset the active OpenGL program.
      */
     void deactivate();
 
@@ -24,6 +24,24 @@ struct region_t
     void clear();
 
     void expand_edges(int amount);
+
+    /**
+     * Reduce the number of rectangles in a fragmented region by growing it.
+     *
+     * If the region has more than max_rects rectangles, its rectangles are
+     * snapped outwards to a grid which gets coarser until the region has at
+     * most max_rects rectangles. The grid stops growing before the fraction
+     * of the resulting region's area which was not in the original region
+     * exceeds max_waste.
+     *
+     * The resulting region always contains the original region.
+     *
+     * @param max_rects The maximal number of rectangles to keep, 0 disables
+     *   coalescing.
+     * @param max_waste The maximal fraction of the area, in [0, 1], which
+     *   may be added to the region.
+     */
+    void coalesce(size_t max_rects, double max_waste);
     pixman_box32_t get_extents() const;
     bool contains_point(const point_t& point) const;
     bool contains_pointf(const pointf_t& point) const;
@@ -13,6 +13,11 @@ struct workspace_stream_t;
  * plugin which sets the hook gains full control over what and how is drawn
  * to the screen. Workspace streams however are not affected.
  *
+ * Render hooks always have to repaint the whole framebuffer. By default, the
+ * whole output is then considered changed. Render hooks which know what has
+ * changed since the previous frame can report it with
+ * render_manager::add_renderer_damage(), see its documentation for details.
+ *
  * @param fb Indicates the framebuffer that the custom renderer should draw to */
 using render_hook_t = std::function<void (const wf::framebuffer_t& fb)>;
 
@@ -55,6 +60,25 @@ enum output_effect_type_t
 using post_hook_t = std::function<void (const wf::framebuffer_base_t& source,
     const wf::framebuffer_base_t& destination)>;
 
+/**
+ * The state of the repaint scheduler of an output.
+ */
+struct repaint_statistics_t
+{
+    /** The scheduler in use, `adaptive` or `predictive`. */
+    std::string scheduler;
+    /** The delay between the start of a refresh cycle and the repaint, in
+     * milliseconds. */
+    int delay = 0;
+    /** The render time which the predictive scheduler reserves, without the
+     * safety margin, in microseconds, or -1 if it is not known yet or the
+     * adaptive scheduler is in use. */
+    int64_t predicted_render_time = -1;
+    /** The fraction of frames which were not presented in time during the
+     * last completed measurement period. */
+    double miss_rate = 0.0;
+};
+
 /** Render manager
  *
  * Each output has a render manager, which is responsible for all rendering
@@ -74,6 +98,26 @@ class render_manager : public wf::signal_provider_t
      */
     void set_renderer(render_hook_t rh = nullptr);
 
+    /**
+     * Report a region of the output which the active render hook has changed
+     * in the current frame. This may be called only from within the render
+     * hook, possibly multiple times, in which case the regions are joined.
+     *
+     * The report is only a hint for presenting the frame: if the render hook
+     * reports damage, only the reported damage and the damage scheduled for
+     * the frame (see get_scheduled_damage()) are submitted as changed since
+     * the previously presented frame. If the hook does not report any damage,
+     * the whole output is submitted as changed.
+     *
+     * The report does not make partial repaints possible. The framebuffer
+     * given to the hook may contain an older frame than the last one, or
+     * nothing at all (for ex. when postprocessing is active), so the hook
+     * must always repaint the whole framebuffer.
+     *
+     * @param region The changed region, in output-local coordinates.
+     */
+    void add_renderer_damage(const wf::region_t& region);
+
     /**
      * Rendering an output is done on demand, that is, when the output is
      * damaged. Some plugins however need to redraw the output as often as
@@ -103,8 +147,11 @@ class render_manager : public wf::signal_provider_t
      * Add a new effect hook.
      * @param hook The hook callback
      * @param type The type of the effect hook
+     * @param name A name for the hook, usually the name of the plugin which
+     *   adds it. It is used to identify the hook in frame timing summaries.
      */
-    void add_effect(effect_hook_t *hook, output_effect_type_t type);
+    void add_effect(effect_hook_t *hook, output_effect_type_t type,
+        const std::string& name = "");
     /**
      * Remove an added effect hook. No-op if the hook wasn't really added.
      * @param hook The hook callback to be removed
@@ -168,6 +215,12 @@ class render_manager : public wf::signal_provider_t
      */
     void damage(const wf::region_t& region);
 
+    /**
+     * @return The current state of the output's repaint scheduler, which can
+     *   be used to compare the schedulers selected by core/repaint_scheduler.
+     */
+    repaint_statistics_t get_repaint_statistics() const;
+
     /**
      * @return A box in output-local coordinates containing the given
      * workspace of the output (returned value depends on current workspace).
@@ -184,6 +237,9 @@ class render_manager : public wf::signal_provider_t
      * Initialize a workspace stream. If you need to change the stream's
      * attributes, you should stop the stream, and start it again
      *
+     * The stream is first rendered with the scale set in its scale_x and
+     * scale_y fields.
+     *
      * @param stream The stream to be initialized
      */
     void workspace_stream_start(workspace_stream_t& stream);
@@ -193,9 +249,16 @@ class render_manager : public wf::signal_provider_t
      * This function should be called inside the rendering cycle, i.e in a
      * render or an overlay hook.
      *
+     * The stream's buffer can be rendered at a lower resolution than the
+     * output, which is useful if the workspace is displayed scaled down. When
+     * the scale changes, the buffer is reallocated and fully repainted.
+     *
      * @param stream The workspace stream to update
-     * @param scale_x Unused for now
-     * @param scale_y Unused for now
+     * @param scale_x The horizontal scale of the stream's buffer, relative to
+     *   the output resolution, in the range (0, 1].
+     * @param scale_y The vertical scale of the stream's buffer. Only uniform
+     *   scaling is supported, so the larger of scale_x and scale_y is used
+     *   for both directions.
      */
     void workspace_stream_update(workspace_stream_t& stream,
         float scale_x = 1, float scale_y = 1);
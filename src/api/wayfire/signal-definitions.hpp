@@ -566,6 +566,13 @@ struct view_focus_request_signal : public _view_signal
  */
 using view_set_sticky_signal = _view_signal;
 
+/**
+ * name: transformer-changed
+ * on: view
+ * when: After a transformer has been added to or removed from the view.
+ */
+using view_transformer_changed_signal = _view_signal;
+
 /**
  * name: title-changed
  * on: view
@@ -3,6 +3,7 @@
 
 #include <cstdint>
 #include <string>
+#include <type_traits>
 #include <vector>
 #include <memory>
 
@@ -95,8 +96,42 @@ class surface_interface_t : public wf::object_base_t
      * surface itself.
      *
      * The surfaces should be ordered from the topmost to the bottom-most one.
+     *
+     * This is a convenience wrapper around for_each_surface(), which is what
+     * the core uses to walk the surface tree, so it cannot be overridden.
+     */
+    std::vector<surface_iterator_t> enumerate_surfaces(
+        wf::point_t surface_origin = {0, 0});
+
+    /**
+     * Call func(const surface_iterator_t&) for each mapped surface in the
+     * surface tree, in the same order as enumerate_surfaces(), without
+     * building a list of the surfaces.
+     *
+     * The surface tree must not be modified from func.
+     *
+     * @param surface_origin The coordinates of the top-left corner of the
+     * surface.
      */
-    virtual std::vector<surface_iterator_t> enumerate_surfaces(
+    template<class Func>
+    void for_each_surface(Func&& func, wf::point_t surface_origin = {0, 0})
+    {
+        using func_t = std::remove_reference_t<Func>;
+        visit_surfaces(surface_origin, (void*)&func,
+            [] (void *data, const surface_iterator_t& child)
+        {
+            (*static_cast<func_t*>(data))(child);
+        });
+    }
+
+    /**
+     * Append each mapped surface in the surface tree to the given list, in
+     * the same order as enumerate_surfaces().
+     *
+     * Callers which keep the list around and clear it before each use do not
+     * allocate memory once the list has grown large enough.
+     */
+    void collect_surfaces(std::vector<surface_iterator_t>& list,
         wf::point_t surface_origin = {0, 0});
 
     /**
@@ -123,7 +158,7 @@ class surface_interface_t : public wf::object_base_t
     /**
      * Test whether the surface accepts touch or pointer input at the given
      * surface-local position. By default, the surface doesn't accept any
-     * input.
+     * input. Surfaces never accept input outside of their size.
      *
      * @return true if the point lies inside the input region of the surface,
      * false otherwise.
@@ -208,6 +243,12 @@ class surface_interface_t : public wf::object_base_t
 
     /* Allow wlr surface implementation to access surface internals */
     friend class wlr_surface_base_t;
+
+  private:
+    using surface_visitor_t = void (*)(void*, const surface_iterator_t&);
+    /** Walk the surface tree, calling visitor(data, child) for each surface */
+    void visit_surfaces(wf::point_t surface_origin, void *data,
+        surface_visitor_t visitor);
 };
 
 void emit_map_state_change(wf::surface_interface_t *surface);
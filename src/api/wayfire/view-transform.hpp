@@ -98,6 +98,10 @@ class view_transformer_t
      * iterate over all rectangles in the damage region, apply framebuffer
      * transform to it and then call render_box(). Plugins can override
      * either of the functions.
+     *
+     * If the transformer is followed by other transformers and
+     * is_output_cacheable() returns true, its output may be cached. See
+     * is_output_cacheable() for details.
      */
     virtual void render_with_damage(wf::texture_t src_tex, wlr_box src_box,
         const wf::region_t& damage, const wf::framebuffer_t& target_fb);
@@ -107,6 +111,53 @@ class view_transformer_t
         wlr_box scissor_box, const wf::framebuffer_t& target_fb)
     {}
 
+    /**
+     * Get the transformation as an affine map and a color multiplier.
+     *
+     * Transformers which only map the view with an affine transformation and
+     * multiply its colors can opt in to being composed with adjacent
+     * transformers which do the same. The whole run of such transformers is
+     * then rendered in a single pass, without intermediate buffers, and their
+     * render_with_damage() is not called. The result has to match
+     * transform_point() and get_bounding_box().
+     *
+     * @param view The bounding box of the view up to this transformer, in
+     *   output-local coordinates.
+     * @param transform Set to the matrix mapping output-local coordinates
+     *   (with z = 0) before the transformer to those after it.
+     * @param color Set to the color multiplier of the transformer.
+     *
+     * @return Whether the transformer is composable. The default
+     *   implementation returns false.
+     */
+    virtual bool get_affine_transform(wf::geometry_t view, glm::mat4& transform,
+        glm::vec4& color)
+    {
+        return false;
+    }
+
+    /**
+     * Whether the output of the transformer may be cached, when other
+     * transformers follow it. A cached output is rendered again only where
+     * the view has been damaged, so transformers which return true must
+     * damage the view with view_interface_t::damage() whenever their
+     * parameters change.
+     *
+     * Transformers whose output depends on more than the view and their own
+     * parameters, e.g. on the contents of the target framebuffer like blur,
+     * must return false.
+     *
+     * The output of composable transformers (see get_affine_transform()) is
+     * always cached, because changes of their transformation are detected
+     * automatically.
+     *
+     * @return The default implementation returns false.
+     */
+    virtual bool is_output_cacheable()
+    {
+        return false;
+    }
+
     view_transformer_t() = default;
     virtual ~view_transformer_t() = default;
     view_transformer_t(const view_transformer_t &) = default;
@@ -143,6 +194,18 @@ class view_2D : public view_transformer_t
         wf::geometry_t view, wf::pointf_t point) override;
     void render_box(wf::texture_t src_tex, wlr_box src_box,
         wlr_box scissor_box, const wf::framebuffer_t& target_fb) override;
+
+    /**
+     * Plain view_2D transformers are composable. Subclasses may render
+     * differently, so they have to opt in by overriding this method and
+     * calling get_2D_transform().
+     */
+    bool get_affine_transform(wf::geometry_t view, glm::mat4& transform,
+        glm::vec4& color) override;
+
+  protected:
+    /** Get the affine map and color multiplier of the 2D transform. */
+    void get_2D_transform(glm::mat4& transform, glm::vec4& color);
 };
 
 /* Those are centered relative to the view's bounding box */
@@ -74,6 +74,30 @@ class view_interface_t : public surface_interface_t
      */
     std::vector<wayfire_view> enumerate_views(bool mapped_only = true);
 
+    /**
+     * Call func(wayfire_view) for each view in the view's tree, in the same
+     * order as enumerate_views(), without building a list of the views.
+     *
+     * The view tree must not be modified from func.
+     *
+     * @param mapped_only Whether to visit only mapped views.
+     */
+    template<class Func>
+    void for_each_view(Func&& func, bool mapped_only = true)
+    {
+        if (!this->is_mapped() && mapped_only)
+        {
+            return;
+        }
+
+        for (auto& child : this->children)
+        {
+            child->for_each_view(func, mapped_only);
+        }
+
+        func(self());
+    }
+
     /**
      * Set the toplevel parent of the view, and adjust the children's list of
      * the parent.
@@ -440,6 +464,35 @@ class view_interface_t : public surface_interface_t
      */
     virtual const wf::framebuffer_t& take_snapshot();
 
+    /**
+     * Get a downscaled snapshot of the view, for plugins which display the
+     * view much smaller than its actual size, like thumbnails.
+     *
+     * The snapshot from take_snapshot() is repeatedly halved in size, and the
+     * smallest of these levels which is still at least as large as the view
+     * scaled to fit into max_width x max_height pixels is returned. Sampling
+     * it instead of the full-size snapshot is cheaper and aliases less.
+     * The levels are kept and only the damaged parts of them are updated
+     * on the next call, until release_lod_snapshots() is called.
+     *
+     * Views whose first transformer is a view_2D (including scale's) or a run
+     * of composable transformers use it automatically when they are shrunk
+     * to half their size or less.
+     *
+     * The geometry of the returned framebuffer is the same as the one of the
+     * full-size snapshot, only its scale is smaller. It is valid until the
+     * next call of this function.
+     *
+     * @param max_width The maximal width at which the view is displayed, in
+     *   pixels.
+     * @param max_height The maximal height at which the view is displayed, in
+     *   pixels.
+     */
+    const wf::framebuffer_t& take_lod_snapshot(int max_width, int max_height);
+
+    /** Free the downscaled snapshots created by take_lod_snapshot(). */
+    void release_lod_snapshots();
+
     /**
      * View lifetime is managed by reference counting. To take a reference,
      * use take_ref(). Note that one reference is automatically made when the
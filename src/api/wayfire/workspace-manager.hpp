@@ -2,6 +2,7 @@
 #define WORKSPACE_MANAGER_HPP
 
 #include <functional>
+#include <memory>
 #include <vector>
 #include <wayfire/view.hpp>
 
@@ -98,6 +99,59 @@ enum sublayer_mode_t
     SUBLAYER_FLOATING     = 2,
 };
 
+/**
+ * A read-only list of views in their stacking order, as returned by
+ * workspace_manager::get_views_in_layer_span().
+ *
+ * The span shares the stacking order cached by the workspace manager instead
+ * of copying it. It stays valid and unchanged even if the stacking order
+ * changes while the span is in use, in which case the cache is rebuilt into
+ * a new list.
+ */
+class view_span_t
+{
+  public:
+    using iterator = std::vector<wayfire_view>::const_iterator;
+
+    view_span_t() = default;
+    explicit view_span_t(std::shared_ptr<const std::vector<wayfire_view>> views) :
+        views(std::move(views))
+    {}
+
+    iterator begin() const
+    {
+        return views ? views->begin() : iterator{};
+    }
+
+    iterator end() const
+    {
+        return views ? views->end() : iterator{};
+    }
+
+    size_t size() const
+    {
+        return views ? views->size() : 0;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    const wayfire_view& operator [](size_t i) const
+    {
+        return (*views)[i];
+    }
+
+    const wayfire_view& front() const
+    {
+        return views->front();
+    }
+
+  private:
+    std::shared_ptr<const std::vector<wayfire_view>> views;
+};
+
 /**
  * Workspace manager is responsible for managing the layers, the workspaces and
  * the views in them. There is one workspace manager per output.
@@ -229,6 +283,23 @@ class workspace_manager
      */
     std::vector<wayfire_view> get_views_in_layer(uint32_t layers_mask);
 
+    /**
+     * Get the same views as get_views_in_layer(), without copying them.
+     *
+     * The stacking order of each layer mask is cached until the stacking
+     * order changes, so repeated queries are cheap. See view_span_t.
+     */
+    view_span_t get_views_in_layer_span(uint32_t layers_mask);
+
+    /**
+     * @return A counter which is incremented whenever the stacking order of
+     *   the views changes, i.e when views are added, removed, restacked or
+     *   (un)promoted, and whenever views move or the current workspace
+     *   changes. Caches of which view is where can be kept while it stays
+     *   the same.
+     */
+    uint64_t get_stack_generation();
+
     /**
      * Get a list of reordered fullscreen views as explained in
      * get_views_in_layer().
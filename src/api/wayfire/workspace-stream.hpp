@@ -14,6 +14,8 @@ struct workspace_stream_t
     wf::framebuffer_base_t buffer;
     bool running = false;
 
+    /* The scale of the buffer relative to the output resolution, as set by
+     * the last call to render_manager::workspace_stream_update() */
     float scale_x = 1.0;
     float scale_y = 1.0;
 
@@ -0,0 +1,255 @@
+#include "framebuffer-pool.hpp"
+#include "opengl-priv.hpp"
+#include <wayfire/util/log.hpp>
+
+/* Idle buffers are freed after this time */
+static constexpr uint32_t IDLE_TIMEOUT_MS = 3000;
+
+static size_t get_buffer_bytes(const wf::framebuffer_pool_t::buffer_t& buffer)
+{
+    /* All formats used by the pool have 4 bytes per pixel */
+    return (size_t)buffer.width * buffer.height * 4;
+}
+
+wf::framebuffer_pool_t& wf::framebuffer_pool_t::get()
+{
+    /* Never destroyed, because the trim timer must not outlive the event
+     * loop. */
+    static auto pool = new framebuffer_pool_t;
+    return *pool;
+}
+
+bool wf::framebuffer_pool_t::acquire(int32_t width, int32_t height,
+    GLenum format, buffer_t& out)
+{
+    if (!take_idle(width, height, format, out) &&
+        !create_buffer(width, height, format, out))
+    {
+        return false;
+    }
+
+    out.acquire_serial = ++acquire_serial;
+    acquired[out.fb]   = out;
+    return true;
+}
+
+bool wf::framebuffer_pool_t::release(GLuint tex, GLuint fb)
+{
+    if (!is_acquired(tex, fb))
+    {
+        return false;
+    }
+
+    auto buffer = acquired[fb];
+    acquired.erase(fb);
+
+    auto key = bucket_key_t{buffer.format, buffer.width, buffer.height};
+    idle[key].push_back({buffer, wf::get_current_time(), ++release_serial});
+    idle_bytes += get_buffer_bytes(buffer);
+    OpenGL::record_texture_memory(buffer.tex, get_buffer_bytes(buffer),
+        "framebuffer pool (idle)");
+
+    enforce_size_limit();
+    schedule_trim();
+    return true;
+}
+
+bool wf::framebuffer_pool_t::is_acquired(GLuint tex, GLuint fb) const
+{
+    auto it = acquired.find(fb);
+    return it != acquired.end() && it->second.tex == tex;
+}
+
+uint64_t wf::framebuffer_pool_t::get_acquire_serial(GLuint fb) const
+{
+    auto it = acquired.find(fb);
+    return (it != acquired.end()) ? it->second.acquire_serial : 0;
+}
+
+void wf::framebuffer_pool_t::clear()
+{
+    for (auto& [_, bucket] : idle)
+    {
+        for (auto& entry : bucket)
+        {
+            destroy_buffer(entry.buffer);
+        }
+    }
+
+    idle.clear();
+    idle_bytes = 0;
+    trim_timer.disconnect();
+}
+
+bool wf::framebuffer_pool_t::take_idle(int32_t width, int32_t height,
+    GLenum format, buffer_t& out)
+{
+    auto bucket = idle.find({format, width, height});
+    if ((bucket != idle.end()) && !bucket->second.empty())
+    {
+        /* Same size, the storage can be reused as it is. Prefer the most
+         * recently used buffer, so that the others become idle long enough
+         * to be trimmed. */
+        out = bucket->second.back().buffer;
+        bucket->second.pop_back();
+        idle_bytes -= get_buffer_bytes(out);
+        if (bucket->second.empty())
+        {
+            idle.erase(bucket);
+        }
+
+        OpenGL::bind_texture(GL_TEXTURE_2D, out.tex);
+        OpenGL::bind_framebuffer(GL_FRAMEBUFFER, out.fb);
+    } else
+    {
+        /* Resizing a buffer still saves creating the GL objects and checking
+         * the framebuffer for completeness. */
+        bucket = find_oldest_idle(format, false);
+        if (bucket == idle.end())
+        {
+            return false;
+        }
+
+        out = bucket->second.front().buffer;
+        pop_oldest_idle(bucket);
+        resize_buffer(out, width, height);
+        OpenGL::bind_framebuffer(GL_FRAMEBUFFER, out.fb);
+    }
+
+    /* A depth buffer attached by the previous user may be smaller than the
+     * buffer now, which would clip rendering to it. */
+    GL_CALL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+        GL_TEXTURE_2D, 0, 0));
+
+    /* Sampling parameters may have been changed by the previous user */
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+    return true;
+}
+
+bool wf::framebuffer_pool_t::create_buffer(int32_t width, int32_t height,
+    GLenum format, buffer_t& out)
+{
+    out = {};
+    out.format = format;
+
+    GL_CALL(glGenFramebuffers(1, &out.fb));
+    GL_CALL(glGenTextures(1, &out.tex));
+    OpenGL::bind_texture(GL_TEXTURE_2D, out.tex);
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+    resize_buffer(out, width, height);
+
+    OpenGL::bind_framebuffer(GL_FRAMEBUFFER, out.fb);
+    GL_CALL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+        GL_TEXTURE_2D, out.tex, 0));
+
+    auto status = GL_CALL(glCheckFramebufferStatus(GL_FRAMEBUFFER));
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        LOGE("Failed to initialize framebuffer: status ", status);
+        destroy_buffer(out);
+        out = {};
+        return false;
+    }
+
+    return true;
+}
+
+void wf::framebuffer_pool_t::resize_buffer(buffer_t& buffer,
+    int32_t width, int32_t height)
+{
+    OpenGL::bind_texture(GL_TEXTURE_2D, buffer.tex);
+    GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, buffer.format, width, height,
+        0, buffer.format, GL_UNSIGNED_BYTE, 0));
+
+    buffer.width  = width;
+    buffer.height = height;
+}
+
+void wf::framebuffer_pool_t::destroy_buffer(const buffer_t& buffer)
+{
+    OpenGL::delete_framebuffer(buffer.fb);
+    OpenGL::delete_texture(buffer.tex);
+    OpenGL::forget_texture_memory(buffer.tex);
+}
+
+std::map<wf::framebuffer_pool_t::bucket_key_t,
+    std::vector<wf::framebuffer_pool_t::idle_buffer_t>>::iterator
+wf::framebuffer_pool_t::find_oldest_idle(GLenum format, bool any_format)
+{
+    auto oldest = idle.end();
+    for (auto it = idle.begin(); it != idle.end(); ++it)
+    {
+        if (!any_format && (std::get<0>(it->first) != format))
+        {
+            continue;
+        }
+
+        /* Each bucket is ordered by release time */
+        if ((oldest == idle.end()) ||
+            (it->second.front().serial < oldest->second.front().serial))
+        {
+            oldest = it;
+        }
+    }
+
+    return oldest;
+}
+
+void wf::framebuffer_pool_t::pop_oldest_idle(
+    std::map<bucket_key_t, std::vector<idle_buffer_t>>::iterator bucket)
+{
+    idle_bytes -= get_buffer_bytes(bucket->second.front().buffer);
+    bucket->second.erase(bucket->second.begin());
+    if (bucket->second.empty())
+    {
+        idle.erase(bucket);
+    }
+}
+
+void wf::framebuffer_pool_t::enforce_size_limit()
+{
+    size_t limit = (size_t)std::max(0, (int)max_pool_size) * 1024 * 1024;
+    while (idle_bytes > limit)
+    {
+        auto bucket = find_oldest_idle(0, true);
+        destroy_buffer(bucket->second.front().buffer);
+        pop_oldest_idle(bucket);
+    }
+}
+
+void wf::framebuffer_pool_t::trim_idle()
+{
+    uint32_t now = wf::get_current_time();
+    while (!idle.empty())
+    {
+        auto bucket = find_oldest_idle(0, true);
+        if (now - bucket->second.front().released_at < IDLE_TIMEOUT_MS)
+        {
+            break;
+        }
+
+        destroy_buffer(bucket->second.front().buffer);
+        pop_oldest_idle(bucket);
+    }
+}
+
+void wf::framebuffer_pool_t::schedule_trim()
+{
+    if (idle.empty() || trim_timer.is_connected())
+    {
+        return;
+    }
+
+    trim_timer.set_timeout(IDLE_TIMEOUT_MS, [=] ()
+    {
+        OpenGL::render_begin();
+        trim_idle();
+        OpenGL::render_end();
+
+        return !idle.empty();
+    });
+}
@@ -0,0 +1,129 @@
+#ifndef WF_FRAMEBUFFER_POOL_HPP
+#define WF_FRAMEBUFFER_POOL_HPP
+
+#include <wayfire/opengl.hpp>
+#include <wayfire/util.hpp>
+#include <wayfire/option-wrapper.hpp>
+
+#include <map>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace wf
+{
+/**
+ * A pool of framebuffers (textures with a framebuffer object attached), which
+ * allows framebuffer_base_t to recycle GL objects instead of creating and
+ * destroying them whenever a buffer is resized or released.
+ *
+ * Released buffers are kept idle in buckets by size and format. If no idle
+ * buffer has the requested size, the least recently used idle buffer with the
+ * same format is resized instead of creating new GL objects. The total size
+ * of the idle buffers is limited by the option core/framebuffer_pool_size,
+ * and buffers which stay idle for a while are freed.
+ *
+ * Unless noted otherwise, the methods have to be called with the GL context
+ * current, i.e between OpenGL::render_begin() and OpenGL::render_end().
+ */
+class framebuffer_pool_t
+{
+  public:
+    struct buffer_t
+    {
+        GLuint tex = -1, fb = -1;
+        int32_t width  = 0;
+        int32_t height = 0;
+        GLenum format  = GL_RGBA;
+        /* Distinguishes the users of the same GL objects */
+        uint64_t acquire_serial = 0;
+    };
+
+    /** Get the pool of the compositor. */
+    static framebuffer_pool_t& get();
+
+    /**
+     * Get a buffer with the given size and format, which is in use until it
+     * is released. The contents of the buffer are undefined.
+     *
+     * Leaves the texture and the framebuffer of the buffer bound. Only the
+     * texture is attached to the framebuffer, attachments added by previous
+     * users of the buffer are removed.
+     *
+     * @return false if a complete framebuffer could not be created.
+     */
+    bool acquire(int32_t width, int32_t height, GLenum format, buffer_t& out);
+
+    /**
+     * Return a buffer to the pool.
+     *
+     * @return false if the texture and the framebuffer were not acquired from
+     *   the pool, in which case they are left untouched.
+     */
+    bool release(GLuint tex, GLuint fb);
+
+    /**
+     * Check whether the given texture and framebuffer were acquired from the
+     * pool and have not been released yet. Does not need a GL context.
+     */
+    bool is_acquired(GLuint tex, GLuint fb) const;
+
+    /**
+     * Get a number which changes whenever the given framebuffer is acquired
+     * from the pool, so that state attached to the framebuffer, for ex. a
+     * depth buffer, can be set up again. Does not need a GL context.
+     *
+     * @return 0 if the framebuffer is not in use from the pool.
+     */
+    uint64_t get_acquire_serial(GLuint fb) const;
+
+    /** Free all idle buffers. */
+    void clear();
+
+  private:
+    using bucket_key_t = std::tuple<GLenum, int32_t, int32_t>;
+    struct idle_buffer_t
+    {
+        buffer_t buffer;
+        /* wf::get_current_time() when the buffer was released */
+        uint32_t released_at;
+        /* Orders the idle buffers by release */
+        uint64_t serial;
+    };
+
+    wf::option_wrapper_t<int> max_pool_size{"core/framebuffer_pool_size"};
+
+    /* Buffers in use, indexed by their framebuffer */
+    std::unordered_map<GLuint, buffer_t> acquired;
+    /* Idle buffers, the most recently released buffer of each bucket last */
+    std::map<bucket_key_t, std::vector<idle_buffer_t>> idle;
+    size_t idle_bytes = 0;
+    uint64_t release_serial = 0;
+    uint64_t acquire_serial = 0;
+
+    wf::wl_timer trim_timer;
+
+    framebuffer_pool_t() = default;
+
+    bool take_idle(int32_t width, int32_t height, GLenum format,
+        buffer_t& out);
+    bool create_buffer(int32_t width, int32_t height, GLenum format,
+        buffer_t& out);
+    void resize_buffer(buffer_t& buffer, int32_t width, int32_t height);
+    void destroy_buffer(const buffer_t& buffer);
+
+    /** Find the least recently released idle buffer with the given format. */
+    std::map<bucket_key_t, std::vector<idle_buffer_t>>::iterator
+    find_oldest_idle(GLenum format, bool any_format);
+    void pop_oldest_idle(
+        std::map<bucket_key_t, std::vector<idle_buffer_t>>::iterator bucket);
+
+    /** Free idle buffers until their size fits in the limit. */
+    void enforce_size_limit();
+    /** Free buffers which have been idle for longer than the idle timeout. */
+    void trim_idle();
+    void schedule_trim();
+};
+}
+
+#endif /* end of include guard: WF_FRAMEBUFFER_POOL_HPP */
@@ -0,0 +1,121 @@
+#include <wayfire/opengl.hpp>
+#include <wayfire/debug.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <unordered_map>
+
+/* With the gpumem logging category, the usage is logged whenever the total
+ * changes by this amount */
+static constexpr size_t LOG_STEP_BYTES = 16 * 1024 * 1024;
+/* Number of owners listed by log_gpu_memory_usage() */
+static constexpr size_t LOG_MAX_OWNERS = 10;
+
+namespace
+{
+struct texture_record_t
+{
+    size_t bytes;
+    std::string owner;
+};
+
+std::unordered_map<GLuint, texture_record_t> texture_records;
+size_t total_bytes = 0;
+size_t last_logged_bytes = 0;
+}
+
+static std::string format_bytes(size_t bytes)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.1f MiB", bytes / (1024.0 * 1024.0));
+    return buf;
+}
+
+static void maybe_log_usage()
+{
+    if (!wf::log::enabled_categories[(size_t)wf::log::logging_category::GPUMEM])
+    {
+        return;
+    }
+
+    size_t change = std::max(total_bytes, last_logged_bytes) -
+        std::min(total_bytes, last_logged_bytes);
+    if (change >= LOG_STEP_BYTES)
+    {
+        last_logged_bytes = total_bytes;
+        OpenGL::log_gpu_memory_usage();
+    }
+}
+
+namespace OpenGL
+{
+void record_texture_memory(GLuint tex, size_t bytes, const std::string& owner)
+{
+    auto& record = texture_records[tex];
+    total_bytes -= record.bytes;
+    total_bytes += bytes;
+    record.bytes = bytes;
+    record.owner = owner;
+    maybe_log_usage();
+}
+
+void forget_texture_memory(GLuint tex)
+{
+    auto it = texture_records.find(tex);
+    if (it != texture_records.end())
+    {
+        total_bytes -= it->second.bytes;
+        texture_records.erase(it);
+        maybe_log_usage();
+    }
+}
+
+std::vector<gpu_memory_usage_t> get_gpu_memory_usage()
+{
+    std::map<std::string, gpu_memory_usage_t> per_owner;
+    for (auto& [_, record] : texture_records)
+    {
+        auto& usage = per_owner[record.owner];
+        usage.bytes += record.bytes;
+        usage.textures++;
+    }
+
+    std::vector<gpu_memory_usage_t> result;
+    for (auto& [owner, usage] : per_owner)
+    {
+        usage.owner = owner;
+        result.push_back(std::move(usage));
+    }
+
+    std::stable_sort(result.begin(), result.end(),
+        [] (const gpu_memory_usage_t& a, const gpu_memory_usage_t& b)
+    {
+        return a.bytes > b.bytes;
+    });
+
+    return result;
+}
+
+size_t get_total_gpu_memory()
+{
+    return total_bytes;
+}
+
+void log_gpu_memory_usage()
+{
+    auto usage = get_gpu_memory_usage();
+    LOGI("GPU memory used by ", texture_records.size(), " textures: ",
+        format_bytes(total_bytes));
+    for (size_t i = 0; i < std::min(usage.size(), LOG_MAX_OWNERS); i++)
+    {
+        LOGI("    ", format_bytes(usage[i].bytes), " in ", usage[i].textures,
+            " textures: ", usage[i].owner);
+    }
+
+    if (usage.size() > LOG_MAX_OWNERS)
+    {
+        LOGI("    ... and ", usage.size() - LOG_MAX_OWNERS, " more owners");
+    }
+}
+}
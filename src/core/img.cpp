@@ -28,6 +28,10 @@ namespace
 {
 std::unordered_map<std::string, Loader> loaders;
 std::unordered_map<std::string, Writer> writers;
+
+/* The size of the texture storage allocated by the current loader. RGB
+ * textures are counted with 4 bytes per pixel, as drivers usually pad them. */
+size_t loaded_bytes = 0;
 }
 
 bool load_data_as_cubemap(unsigned char *data, int width, int height, int channels)
@@ -108,6 +112,7 @@ bool load_data_as_cubemap(unsigned char *data, int width, int height, int channe
 
         GL_CALL(glTexImage2D(t, 0, format, width, height, 0,
             format, GL_UNSIGNED_BYTE, data));
+        loaded_bytes += (size_t)width * height * 4;
     }
 
     GL_CALL(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
@@ -219,6 +224,7 @@ bool texture_from_png(const char *filename, GLuint target)
     {
         GL_CALL(glTexImage2D(target, 0, GL_RGBA, width, height, 0,
             GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid*)data));
+        loaded_bytes += (size_t)width * height * 4;
     }
 
     png_destroy_read_struct(&png, &infos, NULL);
@@ -338,6 +344,7 @@ bool texture_from_jpeg(const char *FileName, GLuint target)
     {
         GL_CALL(glTexImage2D(target, 0, GL_RGB, width, height, 0,
             GL_RGB, GL_UNSIGNED_BYTE, jdata));
+        loaded_bytes += (size_t)width * height * 4;
     }
 
     fclose(file);
@@ -381,10 +388,19 @@ bool load_from_file(std::string name, GLuint target)
         LOGE("load_from_file() called with unsupported extension ", ext);
 
         return false;
-    } else
+    }
+
+    loaded_bytes = 0;
+    if (!it->second(name.c_str(), target))
     {
-        return it->second(name.c_str(), target);
+        return false;
     }
+
+    GLint tex;
+    GL_CALL(glGetIntegerv(target == GL_TEXTURE_CUBE_MAP ?
+        GL_TEXTURE_BINDING_CUBE_MAP : GL_TEXTURE_BINDING_2D, &tex));
+    OpenGL::record_texture_memory(tex, loaded_bytes, "image " + name);
+    return true;
 }
 
 void write_to_file(std::string name, uint8_t *pixels, int w, int h, std::string type)
@@ -1,6 +1,8 @@
 #include "wayfire/object.hpp"
-#include "wayfire/nonstd/safe-list.hpp"
+#include "wayfire/nonstd/safe-vector.hpp"
+#include <deque>
 #include <unordered_map>
+#include <vector>
 #include <set>
 
 /* Implementation note: because of circular dependencies between
@@ -57,14 +59,92 @@ void wf::signal_connection_t::disconnect()
     }
 }
 
+namespace
+{
+/** The names of all signal ids, see signal_id_t. */
+struct signal_registry_t
+{
+    std::unordered_map<std::string, uint32_t> values;
+    /* Indexed by the value of the id. A deque, because get_name() returns
+     * references to the names. */
+    std::deque<std::string> names;
+};
+
+signal_registry_t& get_signal_registry()
+{
+    static signal_registry_t registry;
+    return registry;
+}
+
+/** Find the value of the id with the given name, without registering it. */
+bool find_signal_id(const std::string& name, uint32_t& value)
+{
+    auto& registry = get_signal_registry();
+    auto it = registry.values.find(name);
+    if (it == registry.values.end())
+    {
+        return false;
+    }
+
+    value = it->second;
+    return true;
+}
+}
+
+wf::signal_id_t::signal_id_t(const std::string& name)
+{
+    auto& registry = get_signal_registry();
+    auto it = registry.values.find(name);
+    if (it != registry.values.end())
+    {
+        value = it->second;
+        return;
+    }
+
+    value = registry.names.size();
+    registry.names.push_back(name);
+    registry.values[name] = value;
+}
+
+const std::string& wf::signal_id_t::get_name() const
+{
+    return get_signal_registry().names[value];
+}
+
 class wf::signal_provider_t::sprovider_impl
 {
   public:
-    std::unordered_map<std::string,
-        wf::safe_list_t<signal_connection_t*>> signals;
+    /* Indexed by the values of the signal ids. Entries are never erased, so
+     * that lists are not destroyed while they are being iterated. */
+    std::unordered_map<uint32_t,
+        wf::safe_vector_t<signal_connection_t*>> signals;
 
-    std::unordered_map<std::string,
-        wf::safe_list_t<signal_callback_t*>> deprecated_signals;
+    std::unordered_map<uint32_t,
+        wf::safe_vector_t<signal_callback_t*>> deprecated_signals;
+
+    void emit(uint32_t id, wf::signal_data_t *data)
+    {
+        /* Unlike operator[], find() does not add entries for signals without
+         * connections */
+        auto it = signals.find(id);
+        if (it != signals.end())
+        {
+            it->second.for_each([data] (auto call)
+            {
+                call->emit(data);
+            });
+        }
+
+        /* Deprecated: */
+        auto deprecated = deprecated_signals.find(id);
+        if (deprecated != deprecated_signals.end())
+        {
+            deprecated->second.for_each([data] (auto call)
+            {
+                (*call)(data);
+            });
+        }
+    }
 };
 
 wf::signal_provider_t::signal_provider_t()
@@ -86,7 +166,13 @@ wf::signal_provider_t::~signal_provider_t()
 void wf::signal_provider_t::connect_signal(std::string name,
     signal_connection_t *callback)
 {
-    sprovider_priv->signals[name].push_back(callback);
+    connect_signal(signal_id_t{name}, callback);
+}
+
+void wf::signal_provider_t::connect_signal(const signal_id_t& id,
+    signal_connection_t *callback)
+{
+    sprovider_priv->signals[id.get_value()].push_back(callback);
     callback->priv->add(this);
 }
 
@@ -112,36 +198,150 @@ void wf::signal_provider_t::disconnect_signal(signal_connection_t *connection)
 void wf::signal_provider_t::connect_signal(std::string name,
     signal_callback_t *callback)
 {
-    sprovider_priv->deprecated_signals[name].push_back(callback);
+    sprovider_priv->deprecated_signals[signal_id_t{name}.get_value()].push_back(
+        callback);
 }
 
 /* Deprecated: */
 void wf::signal_provider_t::disconnect_signal(std::string name,
     signal_callback_t *callback)
 {
-    sprovider_priv->deprecated_signals[name].remove_all(callback);
+    uint32_t id;
+    if (find_signal_id(name, id))
+    {
+        sprovider_priv->deprecated_signals[id].remove_all(callback);
+    }
 }
 
 /* Emit the given signal. No type checking for data is required */
 void wf::signal_provider_t::emit_signal(std::string name, wf::signal_data_t *data)
 {
-    sprovider_priv->signals[name].for_each([data] (auto call)
+    /* Nobody has connected to a signal whose name was never registered */
+    uint32_t id;
+    if (find_signal_id(name, id))
     {
-        call->emit(data);
-    });
+        sprovider_priv->emit(id, data);
+    }
+}
 
-    /* Deprecated: */
-    sprovider_priv->deprecated_signals[name].for_each([data] (auto call)
+void wf::signal_provider_t::emit_signal(const signal_id_t& id,
+    wf::signal_data_t *data)
+{
+    sprovider_priv->emit(id.get_value(), data);
+}
+
+namespace
+{
+/** The names of all data slots, see wf::get_data_slot(). */
+struct data_slot_registry_t
+{
+    std::unordered_map<std::string, uint32_t> slots;
+    /* Indexed by the slot */
+    std::vector<std::string> names;
+};
+
+data_slot_registry_t& get_data_slot_registry()
+{
+    static data_slot_registry_t registry;
+    return registry;
+}
+}
+
+uint32_t wf::_register_data_slot(const std::string& name)
+{
+    auto& registry = get_data_slot_registry();
+    auto it = registry.slots.find(name);
+    if (it != registry.slots.end())
     {
-        (*call)(data);
-    });
+        return it->second;
+    }
+
+    uint32_t slot = registry.names.size();
+    registry.names.push_back(name);
+    registry.slots[name] = slot;
+    return slot;
 }
 
 class wf::object_base_t::obase_impl
 {
   public:
+    /* Data stored by type, indexed by the data slot of the type */
+    std::vector<std::unique_ptr<custom_data_t>> slots;
+    /* Data stored by names which are not the names of data slots */
     std::unordered_map<std::string, std::unique_ptr<custom_data_t>> data;
     uint32_t object_id;
+
+    /* The number of registered data slots when the data stored by name was
+     * last checked for the names of slots, see move_named_data() */
+    size_t checked_slots = 0;
+
+    /**
+     * Move data which was stored by name before the slot with this name was
+     * registered to the slot. Names of registered slots are stored in the
+     * slots directly, so this is needed only once per newly registered slot,
+     * and a lookup of an empty slot does not have to search the names.
+     */
+    void move_named_data()
+    {
+        auto& registry = get_data_slot_registry();
+        if (checked_slots == registry.names.size())
+        {
+            return;
+        }
+
+        checked_slots = registry.names.size();
+        for (auto it = data.begin(); it != data.end();)
+        {
+            auto slot = registry.slots.find(it->first);
+            if (slot == registry.slots.end())
+            {
+                ++it;
+                continue;
+            }
+
+            if (slot->second >= slots.size())
+            {
+                slots.resize(slot->second + 1);
+            }
+
+            /* The data in the slot takes precedence, as find() returns it */
+            if (slots[slot->second])
+            {
+                ++it;
+                continue;
+            }
+
+            slots[slot->second] = std::move(it->second);
+            it = data.erase(it);
+        }
+    }
+
+    /** Get the stored data in the given slot, growing the slots if needed */
+    std::unique_ptr<custom_data_t>& get_slot(uint32_t slot)
+    {
+        move_named_data();
+        if (slot >= slots.size())
+        {
+            slots.resize(slot + 1);
+        }
+
+        return slots[slot];
+    }
+
+    /** Find the data with the given name, or return nullptr. If the name is
+     * the name of a data slot, the data is in the slot. */
+    std::unique_ptr<custom_data_t> *find(const std::string& name)
+    {
+        auto& registry = get_data_slot_registry();
+        auto slot = registry.slots.find(name);
+        if (slot != registry.slots.end())
+        {
+            return &get_slot(slot->second);
+        }
+
+        auto it = data.find(name);
+        return it == data.end() ? nullptr : &it->second;
+    }
 };
 
 wf::object_base_t::object_base_t()
@@ -166,42 +366,75 @@ uint32_t wf::object_base_t::get_id() const
 
 bool wf::object_base_t::has_data(std::string name)
 {
-    return obase_priv->data[name] != nullptr;
+    return _fetch_data(name) != nullptr;
 }
 
 void wf::object_base_t::erase_data(std::string name)
 {
-    auto data = std::move(obase_priv->data[name]);
-    obase_priv->data.erase(name);
+    /* Reset the entry before destroying the data, in case the destructor
+     * accesses the data of the object */
+    std::unique_ptr<custom_data_t> data{_fetch_erase(name)};
     data.reset();
 }
 
 wf::custom_data_t*wf::object_base_t::_fetch_data(std::string name)
 {
-    auto it = obase_priv->data.find(name);
-    if (it == obase_priv->data.end())
-    {
-        return nullptr;
-    }
-
-    return it->second.get();
+    auto data = obase_priv->find(name);
+    return data ? data->get() : nullptr;
 }
 
 wf::custom_data_t*wf::object_base_t::_fetch_erase(std::string name)
 {
-    auto data = obase_priv->data[name].release();
-    erase_data(name);
+    auto entry = obase_priv->find(name);
+    if (!entry)
+    {
+        return nullptr;
+    }
 
+    auto data = entry->release();
+    obase_priv->data.erase(name);
     return data;
 }
 
 void wf::object_base_t::_store_data(std::unique_ptr<wf::custom_data_t> data,
     std::string name)
 {
-    obase_priv->data[name] = std::move(data);
+    auto& registry = get_data_slot_registry();
+    auto slot = registry.slots.find(name);
+    if (slot != registry.slots.end())
+    {
+        _store_slot(std::move(data), slot->second);
+    } else
+    {
+        obase_priv->data[name] = std::move(data);
+    }
+}
+
+wf::custom_data_t*wf::object_base_t::_fetch_slot(uint32_t slot)
+{
+    /* A miss neither grows the slots nor searches the data stored by name */
+    obase_priv->move_named_data();
+    if (slot < obase_priv->slots.size())
+    {
+        return obase_priv->slots[slot].get();
+    }
+
+    return nullptr;
+}
+
+wf::custom_data_t*wf::object_base_t::_fetch_erase_slot(uint32_t slot)
+{
+    return obase_priv->get_slot(slot).release();
+}
+
+void wf::object_base_t::_store_slot(std::unique_ptr<wf::custom_data_t> data,
+    uint32_t slot)
+{
+    obase_priv->get_slot(slot) = std::move(data);
 }
 
 void wf::object_base_t::_clear_data()
 {
+    obase_priv->slots.clear();
     obase_priv->data.clear();
 }
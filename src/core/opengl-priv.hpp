@@ -14,6 +14,56 @@ void fini();
 void bind_output(wf::output_t *output, uint32_t fb);
 /** Indicate the output frame has been finished */
 void unbind_output(wf::output_t *output);
+
+/**
+ * Get the number of state changes issued and elided by the GL state tracker
+ * since the last call, and reset the counters.
+ */
+void get_state_statistics(uint64_t& issued, uint64_t& elided);
+
+/**
+ * The core changes the GL state which the OpenGL helpers track only through
+ * the following functions, so that redundant changes can be skipped.
+ */
+void bind_framebuffer(GLenum target, GLuint fb);
+/** Bind a texture to texture unit 0 */
+void bind_texture(GLenum target, GLuint tex);
+void delete_framebuffer(GLuint fb);
+void delete_texture(GLuint tex);
+
+/**
+ * Suspends the GL state tracking while plugin code or wlroots renders, for
+ * ex. render hooks, transformers or wlr_renderer calls. These may change the
+ * GL state in any way, so while a scope exists, the OpenGL helpers issue all
+ * state changes. When the last scope ends, the tracked state is discarded.
+ */
+class untracked_scope_t
+{
+  public:
+    untracked_scope_t();
+    ~untracked_scope_t();
+
+    untracked_scope_t(const untracked_scope_t&) = delete;
+    untracked_scope_t& operator =(const untracked_scope_t&) = delete;
+};
+
+/**
+ * Resumes the GL state tracking inside an untracked scope, when plugin code
+ * calls back into the core for rendering, for ex. to update a workspace
+ * stream.
+ */
+class tracked_scope_t
+{
+  public:
+    tracked_scope_t();
+    ~tracked_scope_t();
+
+    tracked_scope_t(const tracked_scope_t&) = delete;
+    tracked_scope_t& operator =(const tracked_scope_t&) = delete;
+
+  private:
+    int saved_depth;
+};
 }
 
 #endif /* end of include guard: WF_OPENGL_PRIV_HPP */
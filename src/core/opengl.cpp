@@ -1,11 +1,14 @@
 #include <wayfire/util/log.hpp>
+#include <array>
 #include <map>
 #include "opengl-priv.hpp"
+#include "framebuffer-pool.hpp"
 #include "wayfire/output.hpp"
 #include "core-impl.hpp"
 #include "config.h"
 #include <wayfire/nonstd/wlroots-full.hpp>
 
+#include <GLES2/gl2ext.h>
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "shaders.tpp"
@@ -31,7 +34,7 @@ const char *gl_error_string(const GLenum err)
 }
 
 static bool disable_gl_call = false;
-void gl_call(const char *func, uint32_t line, const char *glfunc)
+static void check_gl_error(const char *func, uint32_t line, const char *glfunc)
 {
     GLenum err;
     if (disable_gl_call || ((err = glGetError()) == GL_NO_ERROR))
@@ -40,7 +43,228 @@ void gl_call(const char *func, uint32_t line, const char *glfunc)
     }
 
     LOGE("gles2: function ", glfunc, " in ", func, " line ", line, ": ",
-        gl_error_string(glGetError()));
+        gl_error_string(err));
+    if (err == GL_OUT_OF_MEMORY)
+    {
+        OpenGL::log_gpu_memory_usage();
+    }
+}
+
+namespace
+{
+/**
+ * A shadow copy of the GL state which the OpenGL:: helpers change
+ * frequently, used to skip calls which would not change anything.
+ *
+ * The shadow copy is only valid as long as nobody else changes the state.
+ * The core changes tracked state only through the setters below. Plugins
+ * and wlroots may change it in any way, so tracking is suspended while they
+ * render (see OpenGL::untracked_scope_t): every state change is issued, and
+ * the shadow copy is discarded when the core takes over again.
+ */
+struct gl_state_tracker_t
+{
+    static constexpr GLuint UNKNOWN = (GLuint)-1;
+    enum flag_state_t
+    {
+        FLAG_UNKNOWN  = -1,
+        FLAG_DISABLED = 0,
+        FLAG_ENABLED  = 1,
+    };
+
+    GLuint draw_fb = UNKNOWN;
+    GLuint read_fb = UNKNOWN;
+    bool viewport_valid = false;
+    GLint viewport[4];
+
+    flag_state_t blend   = FLAG_UNKNOWN;
+    flag_state_t scissor = FLAG_UNKNOWN;
+    bool blend_func_valid = false;
+    GLenum blend_src, blend_dst;
+    bool scissor_box_valid = false;
+    GLint scissor_box[4];
+
+    GLuint program = UNKNOWN;
+    GLenum active_texture = UNKNOWN;
+    /* Textures bound to GL_TEXTURE0, per target */
+    GLuint texture_2d = UNKNOWN;
+    GLuint texture_external = UNKNOWN;
+
+    bool clear_color_valid = false;
+    wf::color_t clear_color;
+
+    uint64_t issued = 0;
+    uint64_t elided = 0;
+
+    /* The number of active untracked scopes */
+    int untracked_depth = 0;
+
+    void invalidate()
+    {
+        auto saved_issued = issued, saved_elided = elided;
+        auto saved_depth  = untracked_depth;
+        *this  = {};
+        issued = saved_issued;
+        elided = saved_elided;
+        untracked_depth = saved_depth;
+    }
+
+    /**
+     * Count a call as issued if @changed, elided otherwise. When tracking is
+     * suspended, every call is issued.
+     */
+    bool account(bool changed)
+    {
+        changed |= (untracked_depth > 0);
+        ++(changed ? issued : elided);
+        return changed;
+    }
+
+    void bind_framebuffer(GLenum target, GLuint fb)
+    {
+        bool draw = (target != GL_READ_FRAMEBUFFER);
+        bool read = (target != GL_DRAW_FRAMEBUFFER);
+        if (account((draw && (draw_fb != fb)) || (read && (read_fb != fb))))
+        {
+            GL_CALL(glBindFramebuffer(target, fb));
+            draw_fb = draw ? fb : draw_fb;
+            read_fb = read ? fb : read_fb;
+        }
+    }
+
+    void set_viewport(GLint x, GLint y, GLint w, GLint h)
+    {
+        if (account(!viewport_valid || (viewport[0] != x) ||
+            (viewport[1] != y) || (viewport[2] != w) || (viewport[3] != h)))
+        {
+            GL_CALL(glViewport(x, y, w, h));
+            viewport[0]    = x;
+            viewport[1]    = y;
+            viewport[2]    = w;
+            viewport[3]    = h;
+            viewport_valid = true;
+        }
+    }
+
+    void set_flag(GLenum cap, flag_state_t& current, bool enabled)
+    {
+        auto wanted = enabled ? FLAG_ENABLED : FLAG_DISABLED;
+        if (account(current != wanted))
+        {
+            if (enabled)
+            {
+                GL_CALL(glEnable(cap));
+            } else
+            {
+                GL_CALL(glDisable(cap));
+            }
+
+            current = wanted;
+        }
+    }
+
+    /** Enable premultiplied alpha blending, as used by all helpers */
+    void enable_blending()
+    {
+        set_flag(GL_BLEND, blend, true);
+        if (account(!blend_func_valid || (blend_src != GL_ONE) ||
+            (blend_dst != GL_ONE_MINUS_SRC_ALPHA)))
+        {
+            GL_CALL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
+            blend_src = GL_ONE;
+            blend_dst = GL_ONE_MINUS_SRC_ALPHA;
+            blend_func_valid = true;
+        }
+    }
+
+    void set_scissor_box(GLint x, GLint y, GLint w, GLint h)
+    {
+        set_flag(GL_SCISSOR_TEST, scissor, true);
+        if (account(!scissor_box_valid || (scissor_box[0] != x) ||
+            (scissor_box[1] != y) || (scissor_box[2] != w) ||
+            (scissor_box[3] != h)))
+        {
+            GL_CALL(glScissor(x, y, w, h));
+            scissor_box[0]    = x;
+            scissor_box[1]    = y;
+            scissor_box[2]    = w;
+            scissor_box[3]    = h;
+            scissor_box_valid = true;
+        }
+    }
+
+    void use_program(GLuint id)
+    {
+        if (account(program != id))
+        {
+            GL_CALL(glUseProgram(id));
+            program = id;
+        }
+    }
+
+    void bind_texture(GLenum target, GLuint id)
+    {
+        if (account(active_texture != GL_TEXTURE0))
+        {
+            GL_CALL(glActiveTexture(GL_TEXTURE0));
+            active_texture = GL_TEXTURE0;
+        }
+
+        /* Other targets are not tracked */
+        GLuint *current = (target == GL_TEXTURE_2D) ? &texture_2d :
+            (target == GL_TEXTURE_EXTERNAL_OES) ? &texture_external : nullptr;
+        if (account(!current || (*current != id)))
+        {
+            GL_CALL(glBindTexture(target, id));
+            if (current)
+            {
+                *current = id;
+            }
+        }
+    }
+
+    void set_clear_color(const wf::color_t& color)
+    {
+        if (account(!clear_color_valid || (clear_color.r != color.r) ||
+            (clear_color.g != color.g) || (clear_color.b != color.b) ||
+            (clear_color.a != color.a)))
+        {
+            GL_CALL(glClearColor(color.r, color.g, color.b, color.a));
+            clear_color = color;
+            clear_color_valid = true;
+        }
+    }
+
+    /* Deleting a bound object resets the binding to 0 */
+    void delete_framebuffer(GLuint fb)
+    {
+        GL_CALL(glDeleteFramebuffers(1, &fb));
+        draw_fb = (draw_fb == fb) ? 0 : draw_fb;
+        read_fb = (read_fb == fb) ? 0 : read_fb;
+    }
+
+    void delete_texture(GLuint tex)
+    {
+        GL_CALL(glDeleteTextures(1, &tex));
+        texture_2d = (texture_2d == tex) ? 0 : texture_2d;
+        texture_external = (texture_external == tex) ? 0 : texture_external;
+    }
+
+    /* A program stays in use until another one is used, but its name may be
+     * reused afterwards. */
+    void delete_program(GLuint id)
+    {
+        GL_CALL(glDeleteProgram(id));
+        program = (program == id) ? UNKNOWN : program;
+    }
+};
+
+gl_state_tracker_t gl_state;
+}
+
+void gl_call(const char *func, uint32_t line, const char *glfunc)
+{
+    check_gl_error(func, line, glfunc);
 }
 
 namespace OpenGL
@@ -50,6 +274,64 @@ namespace OpenGL
  * Each of the following functions uses the currently bound context
  */
 program_t program, color_program;
+
+/* Handles of the uniforms and attributes of the default programs */
+struct default_program_handles_t
+{
+    program_t::uniform_t mvp, color, uv_box;
+    program_t::attrib_t position, uv;
+
+    void resolve(program_t& prog)
+    {
+        mvp    = prog.get_uniform("MVP");
+        color  = prog.get_uniform("color");
+        uv_box = prog.get_uniform("uvBox");
+        position = prog.get_attrib("position");
+        uv = prog.get_attrib("uvPosition");
+    }
+};
+
+default_program_handles_t program_handles, color_program_handles;
+
+namespace
+{
+/* A persistent vertex buffer with the corners of the unit square, in the
+ * order expected by GL_TRIANGLE_FAN. */
+GLuint unit_quad_buffer = 0;
+}
+
+static GLuint get_unit_quad_buffer()
+{
+    if (unit_quad_buffer == 0)
+    {
+        static const GLfloat unit_quad[] = {
+            0.0f, 0.0f,
+            1.0f, 0.0f,
+            1.0f, 1.0f,
+            0.0f, 1.0f,
+        };
+
+        GL_CALL(glGenBuffers(1, &unit_quad_buffer));
+        GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, unit_quad_buffer));
+        GL_CALL(glBufferData(GL_ARRAY_BUFFER, sizeof(unit_quad), unit_quad,
+            GL_STATIC_DRAW));
+        GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, 0));
+    }
+
+    return unit_quad_buffer;
+}
+
+/**
+ * Get the matrix which maps the unit quad from get_unit_quad_buffer() to the
+ * given rectangle. The corner (0, 0) is mapped to (x1, y2), matching the
+ * texture coordinates used for the default program.
+ */
+static glm::mat4 get_quad_matrix(const gl_geometry& g)
+{
+    auto translate = glm::translate(glm::mat4(1.0), {g.x1, g.y2, 0.0f});
+    return glm::scale(translate, {g.x2 - g.x1, g.y1 - g.y2, 1.0f});
+}
+
 GLuint compile_shader(std::string source, GLuint type)
 {
     GLuint shader = GL_CALL(glCreateShader(type));
@@ -102,6 +384,8 @@ void init()
     color_program.set_simple(compile_program(default_vertex_shader_source,
         color_rect_fragment_source));
 
+    program_handles.resolve(program);
+    color_program_handles.resolve(color_program);
     render_end();
 }
 
@@ -110,6 +394,13 @@ void fini()
     render_begin();
     program.free_resources();
     color_program.free_resources();
+    wf::framebuffer_pool_t::get().clear();
+    if (unit_quad_buffer)
+    {
+        GL_CALL(glDeleteBuffers(1, &unit_quad_buffer));
+        unit_quad_buffer = 0;
+    }
+
     render_end();
 }
 
@@ -123,16 +414,79 @@ void bind_output(wf::output_t *output, uint32_t fb)
 {
     current_output    = output;
     current_output_fb = fb;
+    /* wlroots has rendered since the last frame */
+    gl_state.invalidate();
 }
 
 void unbind_output(wf::output_t *output)
 {
     current_output    = NULL;
     current_output_fb = 0;
+    gl_state.invalidate();
+}
+
+void invalidate_state()
+{
+    gl_state.invalidate();
+}
+
+untracked_scope_t::untracked_scope_t()
+{
+    ++gl_state.untracked_depth;
+}
+
+untracked_scope_t::~untracked_scope_t()
+{
+    if (--gl_state.untracked_depth == 0)
+    {
+        gl_state.invalidate();
+    }
+}
+
+tracked_scope_t::tracked_scope_t()
+{
+    saved_depth = gl_state.untracked_depth;
+    if (saved_depth > 0)
+    {
+        gl_state.untracked_depth = 0;
+        gl_state.invalidate();
+    }
+}
+
+tracked_scope_t::~tracked_scope_t()
+{
+    if (saved_depth > 0)
+    {
+        gl_state.untracked_depth = saved_depth;
+    }
+}
+
+void bind_framebuffer(GLenum target, GLuint fb)
+{
+    gl_state.bind_framebuffer(target, fb);
 }
 
-std::vector<GLfloat> vertexData;
-std::vector<GLfloat> coordData;
+void bind_texture(GLenum target, GLuint tex)
+{
+    gl_state.bind_texture(target, tex);
+}
+
+void delete_framebuffer(GLuint fb)
+{
+    gl_state.delete_framebuffer(fb);
+}
+
+void delete_texture(GLuint tex)
+{
+    gl_state.delete_texture(tex);
+}
+
+void get_state_statistics(uint64_t& issued, uint64_t& elided)
+{
+    issued = gl_state.issued;
+    elided = gl_state.elided;
+    gl_state.issued = gl_state.elided = 0;
+}
 
 void render_transformed_texture(wf::texture_t tex,
     const gl_geometry& g, const gl_geometry& texg,
@@ -143,13 +497,6 @@ void render_transformed_texture(wf::texture_t tex,
 
     program.use(tex.type);
 
-    vertexData = {
-        g.x1, g.y2,
-        g.x2, g.y2,
-        g.x2, g.y1,
-        g.x1, g.y1,
-    };
-
     gl_geometry final_texg = (bits & TEXTURE_USE_TEX_GEOMETRY) ?
         texg : gl_geometry{0.0f, 0.0f, 1.0f, 1.0f};
 
@@ -165,21 +512,17 @@ void render_transformed_texture(wf::texture_t tex,
         final_texg.x2 = 1.0 - final_texg.x2;
     }
 
-    coordData = {
-        final_texg.x1, final_texg.y1,
-        final_texg.x2, final_texg.y1,
-        final_texg.x2, final_texg.y2,
-        final_texg.x1, final_texg.y2,
-    };
-
+    /* Both the quad and the texture coordinates are computed from the
+     * persistent unit quad, so no vertex data is uploaded. */
+    auto& handles = program_handles;
     program.set_active_texture(tex);
-    program.attrib_pointer("position", 2, 0, vertexData.data());
-    program.attrib_pointer("uvPosition", 2, 0, coordData.data());
-    program.uniformMatrix4f("MVP", model);
-    program.uniform4f("color", color);
+    program.use_unit_quad(handles.position, handles.uv);
+    program.uniformMatrix4f(handles.mvp, model * get_quad_matrix(g));
+    program.uniform4f(handles.uv_box,
+        {final_texg.x1, final_texg.y1, final_texg.x2, final_texg.y2});
+    program.uniform4f(handles.color, color);
 
-    GL_CALL(glEnable(GL_BLEND));
-    GL_CALL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
+    gl_state.enable_blending();
 
     if (bits & RENDER_FLAG_CACHED)
     {
@@ -223,26 +566,146 @@ void render_texture(wf::texture_t texture,
         framebuffer.get_orthographic_projection(), color, bits);
 }
 
+/**
+ * Get the part of the framebuffer geometry which logic_scissor(box) would
+ * leave visible, as a floating-point rectangle.
+ */
+static gl_geometry get_scissor_geometry(const wf::framebuffer_t& fb,
+    const pixman_box32_t& rect)
+{
+    /* framebuffer_box_from_geometry_box() rounds the box outwards after
+     * scaling and before applying the output transform, which maps whole
+     * pixels to whole pixels. */
+    wf::geometry_t box = wlr_box_from_pixman_box(rect);
+    box.x -= fb.geometry.x;
+    box.y -= fb.geometry.y;
+    wf::geometry_t scaled = box * fb.scale;
+
+    return {
+        fb.geometry.x + scaled.x / fb.scale,
+        fb.geometry.y + scaled.y / fb.scale,
+        fb.geometry.x + (scaled.x + scaled.width) / fb.scale,
+        fb.geometry.y + (scaled.y + scaled.height) / fb.scale,
+    };
+}
+
+std::vector<GLfloat> batchVertexData;
+std::vector<GLfloat> batchCoordData;
+
+void render_texture(wf::texture_t texture,
+    const wf::framebuffer_t& framebuffer,
+    const wf::geometry_t& geometry, const wf::region_t& damage,
+    glm::vec4 color, uint32_t bits)
+{
+    bits &= ~(TEXTURE_USE_TEX_GEOMETRY | RENDER_FLAG_CACHED);
+    if (framebuffer.has_nonstandard_transform)
+    {
+        /* Clipping in geometry coordinates is not possible, fall back to
+         * one draw per damaged rectangle. */
+        render_texture(texture, framebuffer, geometry, color,
+            bits | RENDER_FLAG_CACHED);
+        for (const auto& rect : damage)
+        {
+            framebuffer.logic_scissor(wlr_box_from_pixman_box(rect));
+            draw_cached();
+        }
+
+        clear_cached();
+        return;
+    }
+
+    const gl_geometry g = {
+        1.0f * geometry.x, 1.0f * geometry.y,
+        1.0f * geometry.x + geometry.width, 1.0f * geometry.y + geometry.height,
+    };
+
+    gl_geometry texg = {0.0f, 0.0f, 1.0f, 1.0f};
+    if (bits & TEXTURE_TRANSFORM_INVERT_Y)
+    {
+        texg.y1 = 1.0 - texg.y1;
+        texg.y2 = 1.0 - texg.y2;
+    }
+
+    if (bits & TEXTURE_TRANSFORM_INVERT_X)
+    {
+        texg.x1 = 1.0 - texg.x1;
+        texg.x2 = 1.0 - texg.x2;
+    }
+
+    /* Clip the quad to each damaged rectangle and interpolate the texture
+     * coordinates accordingly. Like in render_transformed_texture(), the
+     * bottom of the quad (y2) corresponds to texg.y1. */
+    batchVertexData.clear();
+    batchCoordData.clear();
+    for (const auto& rect : damage)
+    {
+        auto clip = get_scissor_geometry(framebuffer, rect);
+        float x1  = std::max(clip.x1, g.x1);
+        float y1  = std::max(clip.y1, g.y1);
+        float x2  = std::min(clip.x2, g.x2);
+        float y2  = std::min(clip.y2, g.y2);
+        if ((x1 >= x2) || (y1 >= y2))
+        {
+            continue;
+        }
+
+        auto u = [&] (float x)
+        {
+            return texg.x1 + (x - g.x1) / (g.x2 - g.x1) * (texg.x2 - texg.x1);
+        };
+        auto v = [&] (float y)
+        {
+            return texg.y1 + (g.y2 - y) / (g.y2 - g.y1) * (texg.y2 - texg.y1);
+        };
+
+        batchVertexData.insert(batchVertexData.end(), {
+            x1, y2, x2, y2, x2, y1,
+            x1, y2, x2, y1, x1, y1,
+        });
+        batchCoordData.insert(batchCoordData.end(), {
+            u(x1), v(y2), u(x2), v(y2), u(x2), v(y1),
+            u(x1), v(y2), u(x2), v(y1), u(x1), v(y1),
+        });
+    }
+
+    if (batchVertexData.empty())
+    {
+        return;
+    }
+
+    disable_gl_call = true;
+    auto& handles = program_handles;
+    program.use(texture.type);
+    program.set_active_texture(texture);
+    program.attrib_pointer(handles.position, 2, 0, batchVertexData.data());
+    program.attrib_pointer(handles.uv, 2, 0, batchCoordData.data());
+    program.uniformMatrix4f(handles.mvp,
+        framebuffer.get_orthographic_projection());
+    program.uniform4f(handles.uv_box, {0.0f, 0.0f, 1.0f, 1.0f});
+    program.uniform4f(handles.color, color);
+
+    gl_state.enable_blending();
+    gl_state.set_flag(GL_SCISSOR_TEST, gl_state.scissor, false);
+    GL_CALL(glDrawArrays(GL_TRIANGLES, 0, batchVertexData.size() / 2));
+    clear_cached();
+}
+
 void render_rectangle(wf::geometry_t geometry, wf::color_t color,
     glm::mat4 matrix)
 {
     color_program.use(wf::TEXTURE_TYPE_RGBA);
-    float x = geometry.x, y = geometry.y,
-        w = geometry.width, h = geometry.height;
-
-    GLfloat vertexData[] = {
-        x, y + h,
-        x + w, y + h,
-        x + w, y,
-        x, y,
+    gl_geometry g = {
+        1.0f * geometry.x, 1.0f * geometry.y,
+        1.0f * geometry.x + geometry.width, 1.0f * geometry.y + geometry.height,
     };
 
-    color_program.attrib_pointer("position", 2, 0, vertexData);
-    color_program.uniformMatrix4f("MVP", matrix);
-    color_program.uniform4f("color", {color.r, color.g, color.b, color.a});
+    auto& handles = color_program_handles;
+    color_program.use_unit_quad(handles.position);
+    color_program.uniformMatrix4f(handles.mvp, matrix * get_quad_matrix(g));
+    color_program.uniform4f(handles.color,
+        {color.r, color.g, color.b, color.a});
 
-    GL_CALL(glEnable(GL_BLEND));
-    GL_CALL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
+    gl_state.enable_blending();
     GL_CALL(glDrawArrays(GL_TRIANGLE_FAN, 0, 4));
 
     color_program.deactivate();
@@ -255,8 +718,14 @@ void render_begin()
         wlr_egl_make_current(wf::get_core_impl().egl);
     }
 
-    GL_CALL(glEnable(GL_BLEND));
-    GL_CALL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
+    /* Outside of an output repaint, wlroots may have rendered since we last
+     * touched the state. */
+    if (!current_output)
+    {
+        gl_state.invalidate();
+    }
+
+    gl_state.enable_blending();
 }
 
 void render_begin(const wf::framebuffer_base_t& fb)
@@ -269,20 +738,20 @@ void render_begin(int32_t width, int32_t height, uint32_t fb)
 {
     render_begin();
 
-    GL_CALL(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fb));
-    GL_CALL(glViewport(0, 0, width, height));
+    gl_state.bind_framebuffer(GL_DRAW_FRAMEBUFFER, fb);
+    gl_state.set_viewport(0, 0, width, height);
 }
 
 void clear(wf::color_t col, uint32_t mask)
 {
-    GL_CALL(glClearColor(col.r, col.g, col.b, col.a));
+    gl_state.set_clear_color(col);
     GL_CALL(glClear(mask));
 }
 
 void render_end()
 {
-    GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, current_output_fb));
-    GL_CALL(glDisable(GL_SCISSOR_TEST));
+    gl_state.bind_framebuffer(GL_FRAMEBUFFER, current_output_fb);
+    gl_state.set_flag(GL_SCISSOR_TEST, gl_state.scissor, false);
 }
 }
 
@@ -310,6 +779,44 @@ static std::string framebuffer_status_to_str(
 
 bool wf::framebuffer_base_t::allocate(int width, int height)
 {
+    auto& pool = wf::framebuffer_pool_t::get();
+    bool from_pool = (fb == (uint32_t)-1) && (tex == (uint32_t)-1);
+    if (pool.is_acquired(tex, fb))
+    {
+        if ((width == viewport_width) && (height == viewport_height))
+        {
+            return false;
+        }
+
+        /* Exchange the buffer for one with the new size */
+        pool.release(tex, fb);
+        from_pool = true;
+    }
+
+    if (from_pool)
+    {
+        reset();
+        wf::framebuffer_pool_t::buffer_t buffer;
+        if (!pool.acquire(width, height, GL_RGBA, buffer))
+        {
+            OpenGL::bind_texture(GL_TEXTURE_2D, 0);
+            OpenGL::bind_framebuffer(GL_FRAMEBUFFER, OpenGL::current_output_fb);
+            return false;
+        }
+
+        fb  = buffer.fb;
+        tex = buffer.tex;
+        viewport_width  = width;
+        viewport_height = height;
+        OpenGL::record_texture_memory(tex, (size_t)width * height * 4,
+            owner.empty() ? "unknown framebuffer" : owner);
+
+        OpenGL::bind_texture(GL_TEXTURE_2D, 0);
+        OpenGL::bind_framebuffer(GL_FRAMEBUFFER, OpenGL::current_output_fb);
+        return true;
+    }
+
+    /* The texture and/or the framebuffer were set up externally */
     bool first_allocate = false;
     if (fb == (uint32_t)-1)
     {
@@ -321,7 +828,7 @@ bool wf::framebuffer_base_t::allocate(int width, int height)
     {
         first_allocate = true;
         GL_CALL(glGenTextures(1, &tex));
-        GL_CALL(glBindTexture(GL_TEXTURE_2D, tex));
+        OpenGL::bind_texture(GL_TEXTURE_2D, tex);
         GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
         GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
         GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
@@ -337,16 +844,18 @@ bool wf::framebuffer_base_t::allocate(int width, int height)
             (height != viewport_height))
         {
             is_resize = true;
-            GL_CALL(glBindTexture(GL_TEXTURE_2D, tex));
+            OpenGL::bind_texture(GL_TEXTURE_2D, tex);
             GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height,
                 0, GL_RGBA, GL_UNSIGNED_BYTE, 0));
+            OpenGL::record_texture_memory(tex, (size_t)width * height * 4,
+                owner.empty() ? "unknown framebuffer" : owner);
         }
     }
 
     if (first_allocate)
     {
-        GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, fb));
-        GL_CALL(glBindTexture(GL_TEXTURE_2D, tex));
+        OpenGL::bind_framebuffer(GL_FRAMEBUFFER, fb);
+        OpenGL::bind_texture(GL_TEXTURE_2D, tex);
         GL_CALL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
             GL_TEXTURE_2D, tex, 0));
 
@@ -363,8 +872,8 @@ bool wf::framebuffer_base_t::allocate(int width, int height)
     viewport_width  = width;
     viewport_height = height;
 
-    GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
-    GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, OpenGL::current_output_fb));
+    OpenGL::bind_texture(GL_TEXTURE_2D, 0);
+    OpenGL::bind_framebuffer(GL_FRAMEBUFFER, OpenGL::current_output_fb);
 
     return is_resize || first_allocate;
 }
@@ -374,8 +883,9 @@ void wf::framebuffer_base_t::copy_state(wf::framebuffer_base_t&& other)
     this->viewport_width  = other.viewport_width;
     this->viewport_height = other.viewport_height;
 
-    this->fb  = other.fb;
-    this->tex = other.tex;
+    this->fb    = other.fb;
+    this->tex   = other.tex;
+    this->owner = other.owner;
 
     other.reset();
 }
@@ -401,27 +911,33 @@ wf::framebuffer_base_t& wf::framebuffer_base_t::operator =(
 
 void wf::framebuffer_base_t::bind() const
 {
-    GL_CALL(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fb));
-    GL_CALL(glViewport(0, 0, viewport_width, viewport_height));
+    gl_state.bind_framebuffer(GL_DRAW_FRAMEBUFFER, fb);
+    gl_state.set_viewport(0, 0, viewport_width, viewport_height);
 }
 
 void wf::framebuffer_base_t::scissor(wlr_box box) const
 {
-    GL_CALL(glEnable(GL_SCISSOR_TEST));
-    GL_CALL(glScissor(box.x, viewport_height - box.y - box.height,
-        box.width, box.height));
+    gl_state.set_scissor_box(box.x, viewport_height - box.y - box.height,
+        box.width, box.height);
 }
 
 void wf::framebuffer_base_t::release()
 {
+    if (wf::framebuffer_pool_t::get().release(tex, fb))
+    {
+        reset();
+        return;
+    }
+
     if ((fb != uint32_t(-1)) && (fb != 0))
     {
-        GL_CALL(glDeleteFramebuffers(1, &fb));
+        OpenGL::delete_framebuffer(fb);
     }
 
     if ((tex != uint32_t(-1)) && ((fb != 0) || (tex != 0)))
     {
-        GL_CALL(glDeleteTextures(1, &tex));
+        OpenGL::delete_texture(tex);
+        OpenGL::forget_texture_memory(tex);
     }
 
     reset();
@@ -580,37 +1096,120 @@ class program_t::impl
     int active_program_idx = 0;
 
     int id[wf::TEXTURE_TYPE_ALL];
-    std::unordered_map<std::string, int> uniforms[wf::TEXTURE_TYPE_ALL];
 
-    /** Find the uniform location for the currently bound program */
-    int find_uniform_loc(const std::string& name)
+    /* Locations of the registered uniforms and attributes, indexed by their
+     * handle and the texture type. */
+    using locations_t = std::array<int, wf::TEXTURE_TYPE_ALL>;
+    std::unordered_map<std::string, int> uniform_ids;
+    std::vector<std::string> uniform_names;
+    std::vector<locations_t> uniform_locs;
+
+    std::unordered_map<std::string, int> attrib_ids;
+    std::vector<std::string> attrib_names;
+    std::vector<locations_t> attrib_locs;
+
+    /* Handles of the builtin uniforms of programs created with compile() */
+    uniform_t uv_base, uv_scale;
+
+    /* A vertex array object per texture type which sources the attributes
+     * from the unit quad buffer, and the attributes it was set up for. */
+    GLuint quad_vao[wf::TEXTURE_TYPE_ALL];
+    std::pair<int, int> quad_vao_attribs[wf::TEXTURE_TYPE_ALL];
+    bool quad_vao_bound = false;
+
+    /** Go back to the default vertex array, which holds client-side data. */
+    void unbind_quad_vao()
     {
-        auto it = uniforms[active_program_idx].find(name);
-        if (it != uniforms[active_program_idx].end())
+        if (quad_vao_bound)
         {
-            return it->second;
+            GL_CALL(glBindVertexArray(0));
+            quad_vao_bound = false;
         }
+    }
 
-        uniforms[active_program_idx][name] =
-            GL_CALL(glGetUniformLocation(id[active_program_idx], name.c_str()));
+    locations_t resolve(const std::string& name, bool uniform)
+    {
+        locations_t locs;
+        for (int i = 0; i < wf::TEXTURE_TYPE_ALL; i++)
+        {
+            if (id[i] == 0)
+            {
+                locs[i] = -1;
+            } else if (uniform)
+            {
+                locs[i] = GL_CALL(glGetUniformLocation(id[i], name.c_str()));
+            } else
+            {
+                locs[i] = GL_CALL(glGetAttribLocation(id[i], name.c_str()));
+            }
+        }
 
-        return uniforms[active_program_idx][name];
+        return locs;
     }
 
-    std::map<std::string, int> attribs[wf::TEXTURE_TYPE_ALL];
-    /** Find the attrib location for the currently bound program */
-    int find_attrib_loc(const std::string& name)
+    /** Resolve the locations of all registered handles after relinking */
+    void resolve_all()
+    {
+        for (size_t i = 0; i < uniform_names.size(); i++)
+        {
+            uniform_locs[i] = resolve(uniform_names[i], true);
+        }
+
+        for (size_t i = 0; i < attrib_names.size(); i++)
+        {
+            attrib_locs[i] = resolve(attrib_names[i], false);
+        }
+    }
+
+    int get_uniform_id(const std::string& name)
+    {
+        auto it = uniform_ids.find(name);
+        if (it != uniform_ids.end())
+        {
+            return it->second;
+        }
+
+        uniform_names.push_back(name);
+        uniform_locs.push_back(resolve(name, true));
+        return uniform_ids[name] = uniform_names.size() - 1;
+    }
+
+    int get_attrib_id(const std::string& name)
     {
-        auto it = attribs[active_program_idx].find(name);
-        if (it != attribs[active_program_idx].end())
+        auto it = attrib_ids.find(name);
+        if (it != attrib_ids.end())
         {
             return it->second;
         }
 
-        attribs[active_program_idx][name] =
-            GL_CALL(glGetAttribLocation(id[active_program_idx], name.c_str()));
+        attrib_names.push_back(name);
+        attrib_locs.push_back(resolve(name, false));
+        return attrib_ids[name] = attrib_names.size() - 1;
+    }
+
+    /** Find the uniform location for the currently bound program */
+    int uniform_loc(const uniform_t& uniform)
+    {
+        return (uniform.id < 0) ? -1 : uniform_locs[uniform.id][active_program_idx];
+    }
+
+    /** Find the attrib location for the currently bound program */
+    int attrib_loc(const attrib_t& attrib)
+    {
+        return (attrib.id < 0) ? -1 : attrib_locs[attrib.id][active_program_idx];
+    }
 
-        return attribs[active_program_idx][name];
+    void free_quad_vaos()
+    {
+        for (int i = 0; i < wf::TEXTURE_TYPE_ALL; i++)
+        {
+            if (quad_vao[i])
+            {
+                GL_CALL(glDeleteVertexArrays(1, &quad_vao[i]));
+                quad_vao[i] = 0;
+                quad_vao_attribs[i] = {-1, -1};
+            }
+        }
     }
 };
 
@@ -620,6 +1219,8 @@ program_t::program_t()
     for (int i = 0; i < wf::TEXTURE_TYPE_ALL; i++)
     {
         this->priv->id[i] = 0;
+        this->priv->quad_vao[i] = 0;
+        this->priv->quad_vao_attribs[i] = {-1, -1};
     }
 }
 
@@ -628,6 +1229,7 @@ void program_t::set_simple(GLuint program_id, wf::texture_type_t type)
     free_resources();
     assert(type < wf::TEXTURE_TYPE_ALL);
     this->priv->id[type] = program_id;
+    this->priv->resolve_all();
 }
 
 program_t::~program_t()
@@ -674,6 +1276,10 @@ void program_t::compile(const std::string& vertex_source,
         this->priv->id[program_type.first] =
             compile_program(vertex_source, fragment);
     }
+
+    priv->resolve_all();
+    priv->uv_base  = get_uniform("_wayfire_uv_base");
+    priv->uv_scale = get_uniform("_wayfire_uv_scale");
 }
 
 void program_t::free_resources()
@@ -682,10 +1288,12 @@ void program_t::free_resources()
     {
         if (this->priv->id[i])
         {
-            GL_CALL(glDeleteProgram(priv->id[i]));
+            gl_state.delete_program(priv->id[i]);
             this->priv->id[i] = 0;
         }
     }
+
+    priv->free_quad_vaos();
 }
 
 void program_t::use(wf::texture_type_t type)
@@ -696,7 +1304,7 @@ void program_t::use(wf::texture_type_t type)
             std::to_string(type));
     }
 
-    GL_CALL(glUseProgram(priv->id[type]));
+    gl_state.use_program(priv->id[type]);
     priv->active_program_idx = type;
 }
 
@@ -705,63 +1313,162 @@ int program_t::get_program_id(wf::texture_type_t type)
     return priv->id[type];
 }
 
+program_t::uniform_t program_t::get_uniform(const std::string& name)
+{
+    return {priv->get_uniform_id(name)};
+}
+
+program_t::attrib_t program_t::get_attrib(const std::string& name)
+{
+    return {priv->get_attrib_id(name)};
+}
+
 void program_t::uniform1i(const std::string& name, int value)
 {
-    int loc = priv->find_uniform_loc(name);
-    GL_CALL(glUniform1i(loc, value));
+    uniform1i(get_uniform(name), value);
 }
 
 void program_t::uniform1f(const std::string& name, float value)
 {
-    int loc = priv->find_uniform_loc(name);
-    GL_CALL(glUniform1f(loc, value));
+    uniform1f(get_uniform(name), value);
 }
 
 void program_t::uniform2f(const std::string& name, float x, float y)
 {
-    int loc = priv->find_uniform_loc(name);
-    GL_CALL(glUniform2f(loc, x, y));
+    uniform2f(get_uniform(name), x, y);
 }
 
 void program_t::uniform3f(const std::string& name, float x, float y, float z)
 {
-    int loc = priv->find_uniform_loc(name);
-    GL_CALL(glUniform3f(loc, x, y, z));
+    uniform3f(get_uniform(name), x, y, z);
 }
 
 void program_t::uniform4f(const std::string& name, const glm::vec4& value)
 {
-    int loc = priv->find_uniform_loc(name);
-    GL_CALL(glUniform4f(loc, value.r, value.g, value.b, value.a));
+    uniform4f(get_uniform(name), value);
 }
 
 void program_t::uniformMatrix4f(const std::string& name, const glm::mat4& value)
 {
-    int loc = priv->find_uniform_loc(name);
-    GL_CALL(glUniformMatrix4fv(loc, 1, GL_FALSE, &value[0][0]));
+    uniformMatrix4f(get_uniform(name), value);
 }
 
 void program_t::attrib_pointer(const std::string& attrib,
     int size, int stride, const void *ptr, GLenum type)
 {
-    int loc = priv->find_attrib_loc(attrib);
+    attrib_pointer(get_attrib(attrib), size, stride, ptr, type);
+}
+
+void program_t::attrib_divisor(const std::string& attrib, int divisor)
+{
+    attrib_divisor(get_attrib(attrib), divisor);
+}
+
+void program_t::uniform1i(uniform_t uniform, int value)
+{
+    GL_CALL(glUniform1i(priv->uniform_loc(uniform), value));
+}
+
+void program_t::uniform1f(uniform_t uniform, float value)
+{
+    GL_CALL(glUniform1f(priv->uniform_loc(uniform), value));
+}
+
+void program_t::uniform2f(uniform_t uniform, float x, float y)
+{
+    GL_CALL(glUniform2f(priv->uniform_loc(uniform), x, y));
+}
+
+void program_t::uniform3f(uniform_t uniform, float x, float y, float z)
+{
+    GL_CALL(glUniform3f(priv->uniform_loc(uniform), x, y, z));
+}
+
+void program_t::uniform4f(uniform_t uniform, const glm::vec4& value)
+{
+    GL_CALL(glUniform4f(priv->uniform_loc(uniform),
+        value.r, value.g, value.b, value.a));
+}
+
+void program_t::uniformMatrix4f(uniform_t uniform, const glm::mat4& value)
+{
+    GL_CALL(glUniformMatrix4fv(priv->uniform_loc(uniform),
+        1, GL_FALSE, &value[0][0]));
+}
+
+void program_t::attrib_pointer(attrib_t attrib,
+    int size, int stride, const void *ptr, GLenum type)
+{
+    /* Client-side data cannot be used with the unit quad's vertex array */
+    priv->unbind_quad_vao();
+    int loc = priv->attrib_loc(attrib);
     priv->active_attrs.insert(loc);
 
     GL_CALL(glEnableVertexAttribArray(loc));
     GL_CALL(glVertexAttribPointer(loc, size, type, GL_FALSE, stride, ptr));
 }
 
-void program_t::attrib_divisor(const std::string& attrib, int divisor)
+void program_t::attrib_divisor(attrib_t attrib, int divisor)
 {
-    int loc = priv->find_attrib_loc(attrib);
+    priv->unbind_quad_vao();
+    int loc = priv->attrib_loc(attrib);
     priv->active_attrs_divisors.insert(loc);
     GL_CALL(glVertexAttribDivisor(loc, divisor));
 }
 
+void program_t::use_unit_quad(attrib_t position)
+{
+    use_unit_quad(position, attrib_t{});
+}
+
+void program_t::use_unit_quad(attrib_t position, attrib_t uv)
+{
+    const int idx = priv->active_program_idx;
+    const std::pair<int, int> locs = {
+        priv->attrib_loc(position),
+        priv->attrib_loc(uv),
+    };
+
+    if (priv->quad_vao[idx] && (priv->quad_vao_attribs[idx] == locs))
+    {
+        GL_CALL(glBindVertexArray(priv->quad_vao[idx]));
+        priv->quad_vao_bound = true;
+        return;
+    }
+
+    if (!priv->quad_vao[idx])
+    {
+        GL_CALL(glGenVertexArrays(1, &priv->quad_vao[idx]));
+    }
+
+    GL_CALL(glBindVertexArray(priv->quad_vao[idx]));
+    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, get_unit_quad_buffer()));
+    for (int loc : {priv->quad_vao_attribs[idx].first,
+                    priv->quad_vao_attribs[idx].second})
+    {
+        if (loc >= 0)
+        {
+            GL_CALL(glDisableVertexAttribArray(loc));
+        }
+    }
+
+    for (int loc : {locs.first, locs.second})
+    {
+        if (loc >= 0)
+        {
+            GL_CALL(glEnableVertexAttribArray(loc));
+            GL_CALL(glVertexAttribPointer(loc, 2, GL_FLOAT, GL_FALSE, 0, 0));
+        }
+    }
+
+    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, 0));
+    priv->quad_vao_attribs[idx] = locs;
+    priv->quad_vao_bound = true;
+}
+
 void program_t::set_active_texture(const wf::texture_t& texture)
 {
-    GL_CALL(glActiveTexture(GL_TEXTURE0));
-    GL_CALL(glBindTexture(texture.target, texture.tex_id));
+    gl_state.bind_texture(texture.target, texture.tex_id);
     GL_CALL(glTexParameteri(texture.target, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
 
     glm::vec2 base{0.0f, 0.0f};
@@ -781,12 +1488,14 @@ void program_t::set_active_texture(const wf::texture_t& texture)
         base.y   = 1.0 - base.y;
     }
 
-    uniform2f("_wayfire_uv_base", base.x, base.y);
-    uniform2f("_wayfire_uv_scale", scale.x, scale.y);
+    uniform2f(priv->uv_base, base.x, base.y);
+    uniform2f(priv->uv_scale, scale.x, scale.y);
 }
 
 void program_t::deactivate()
 {
+    /* The attributes below were set up in the default vertex array */
+    priv->unbind_quad_vao();
     for (int loc : priv->active_attrs_divisors)
     {
         GL_CALL(glVertexAttribDivisor(loc, 0));
@@ -799,6 +1508,6 @@ void program_t::deactivate()
 
     priv->active_attrs_divisors.clear();
     priv->active_attrs.clear();
-    GL_CALL(glUseProgram(0));
+    gl_state.use_program(0);
 }
 }
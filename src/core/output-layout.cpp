@@ -10,6 +10,7 @@
 #include "seat/seat.hpp"
 #include "seat/cursor.hpp"
 #include "core-impl.hpp"
+#include "opengl-priv.hpp"
 
 #include <xf86drmMode.h>
 #include <sstream>
@@ -634,6 +635,7 @@ struct output_layout_output_t
     void render_output(wlr_texture *texture)
     {
         auto renderer = get_core().renderer;
+        OpenGL::untracked_scope_t wlroots_gl;
         wlr_output_attach_render(handle, NULL);
         wlr_renderer_begin(renderer, handle->width, handle->height);
 
@@ -9,7 +9,9 @@
 #include "wayfire/output-layout.hpp"
 #include "tablet.hpp"
 #include "wayfire/signal-definitions.hpp"
+#include "wayfire/render-manager.hpp"
 #include "wayfire/util/log.hpp"
+#include "wayfire/debug.hpp"
 
 wf::cursor_t::cursor_t(wf::seat_t *seat)
 {
@@ -36,6 +38,33 @@ wf::cursor_t::cursor_t(wf::seat_t *seat)
         set_cursor(ev, true);
     });
     request_set_cursor.connect(&seat->seat->events.request_set_cursor);
+
+    on_motion_frame = [=] ()
+    {
+        auto motion = motion_coalescer.frame();
+        if (!motion)
+        {
+            stop_motion_frames();
+            return;
+        }
+
+        process_pointer_motion(*motion);
+        wlr_seat_pointer_notify_frame(seat->seat);
+        schedule_motion_frame();
+    };
+
+    on_output_removed.set_callback([=] (wf::signal_data_t *data)
+    {
+        if (wf::get_signaled_output(data) == motion_frame_output)
+        {
+            /* The cursor has already moved, its focus is updated with the
+             * next event */
+            stop_motion_frames();
+            motion_coalescer.reset();
+        }
+    });
+    wf::get_core().output_layout->connect_signal("output-removed",
+        &on_output_removed);
 }
 
 void wf::cursor_t::add_new_device(wlr_input_device *dev)
@@ -59,16 +88,18 @@ void wf::cursor_t::setup_listeners()
 #define setup_passthrough_callback(evname) \
     on_ ## evname.set_callback([&] (void *data) { \
         set_touchscreen_mode(false); \
+        flush_pending_motion(); \
+        static const wf::signal_id_t event_id{"pointer_" #evname}; \
+        static const wf::signal_id_t post_id{"pointer_" #evname "_post"}; \
         auto ev   = static_cast<wlr_event_pointer_ ## evname*>(data); \
-        auto mode = emit_device_event_signal("pointer_" #evname, ev); \
+        auto mode = emit_device_event_signal(event_id, ev); \
         seat->lpointer->handle_pointer_ ## evname(ev, mode); \
         wlr_idle_notify_activity(core.protocols.idle, core.get_current_seat()); \
-        emit_device_event_signal("pointer_" #evname "_post", ev); \
+        emit_device_event_signal(post_id, ev); \
     }); \
     on_ ## evname.connect(&cursor->events.evname);
 
     setup_passthrough_callback(button);
-    setup_passthrough_callback(motion);
     setup_passthrough_callback(motion_absolute);
     setup_passthrough_callback(axis);
     setup_passthrough_callback(swipe_begin);
@@ -79,6 +110,14 @@ void wf::cursor_t::setup_listeners()
     setup_passthrough_callback(pinch_end);
 #undef setup_passthrough_callback
 
+    on_motion.set_callback([&] (void *data)
+    {
+        set_touchscreen_mode(false);
+        handle_pointer_motion(static_cast<wlr_event_pointer_motion*>(data));
+        wlr_idle_notify_activity(core.protocols.idle, core.get_current_seat());
+    });
+    on_motion.connect(&cursor->events.motion);
+
     /**
      * All tablet events are directly sent to the tablet device, it should
      * manage them
@@ -86,15 +125,18 @@ void wf::cursor_t::setup_listeners()
 #define setup_tablet_callback(evname) \
     on_tablet_ ## evname.set_callback([&] (void *data) { \
         set_touchscreen_mode(false); \
+        flush_pending_motion(); \
+        static const wf::signal_id_t event_id{"tablet_" #evname}; \
+        static const wf::signal_id_t post_id{"tablet_" #evname "_post"}; \
         auto ev = static_cast<wlr_event_tablet_tool_ ## evname*>(data); \
-        auto handling_mode = emit_device_event_signal("tablet_" #evname, ev); \
+        auto handling_mode = emit_device_event_signal(event_id, ev); \
         if (ev->device->tablet->data) { \
             auto tablet = \
                 static_cast<wf::tablet_t*>(ev->device->tablet->data); \
             tablet->handle_ ## evname(ev, handling_mode); \
         } \
         wlr_idle_notify_activity(wf::get_core().protocols.idle, seat->seat); \
-        emit_device_event_signal("tablet_" #evname "_post", ev); \
+        emit_device_event_signal(post_id, ev); \
     }); \
     on_tablet_ ## evname.connect(&cursor->events.tablet_tool_ ## evname);
 
@@ -105,6 +147,96 @@ void wf::cursor_t::setup_listeners()
 #undef setup_tablet_callback
 }
 
+/* ------------------------- Motion coalescing ------------------------------ */
+void wf::cursor_t::handle_pointer_motion(wlr_event_pointer_motion *ev)
+{
+    if (!coalesce_motion || !seat->lpointer->can_coalesce_motion())
+    {
+        flush_pending_motion();
+        process_pointer_motion(ev);
+        return;
+    }
+
+    auto motion = motion_coalescer.add({ev->device, ev->time_msec,
+        ev->delta_x, ev->delta_y, ev->unaccel_dx, ev->unaccel_dy});
+    if (motion)
+    {
+        process_pointer_motion(*motion);
+    }
+
+    schedule_motion_frame();
+
+    const auto& stats = motion_coalescer.get_stats();
+    if (stats.received % 1024 == 0)
+    {
+        LOGC(INPUT, "Pointer motion: ", stats.received, " events, ",
+            stats.folded, " folded");
+    }
+}
+
+void wf::cursor_t::process_pointer_motion(wlr_event_pointer_motion *ev)
+{
+    static const wf::signal_id_t event_id{"pointer_motion"};
+    static const wf::signal_id_t post_id{"pointer_motion_post"};
+
+    auto mode = emit_device_event_signal(event_id, ev);
+    seat->lpointer->handle_pointer_motion(ev, mode);
+    emit_device_event_signal(post_id, ev);
+}
+
+void wf::cursor_t::process_pointer_motion(const wf::pointer_motion_t& motion)
+{
+    wlr_event_pointer_motion ev{};
+    ev.device     = static_cast<wlr_input_device*>(motion.device);
+    ev.time_msec  = motion.time_msec;
+    ev.delta_x    = motion.delta_x;
+    ev.delta_y    = motion.delta_y;
+    ev.unaccel_dx = motion.unaccel_dx;
+    ev.unaccel_dy = motion.unaccel_dy;
+    process_pointer_motion(&ev);
+}
+
+void wf::cursor_t::flush_pending_motion()
+{
+    auto motion = motion_coalescer.take();
+    if (motion)
+    {
+        process_pointer_motion(*motion);
+    }
+}
+
+void wf::cursor_t::schedule_motion_frame()
+{
+    auto gc     = get_cursor_position();
+    auto output = wf::get_core().output_layout->get_output_at(gc.x, gc.y);
+    if (!output)
+    {
+        flush_pending_motion();
+        stop_motion_frames();
+        motion_coalescer.reset();
+        return;
+    }
+
+    if (output != motion_frame_output)
+    {
+        stop_motion_frames();
+        motion_frame_output = output;
+        output->render->add_effect(&on_motion_frame, wf::OUTPUT_EFFECT_PRE,
+            "pointer-motion");
+    }
+
+    output->render->schedule_redraw();
+}
+
+void wf::cursor_t::stop_motion_frames()
+{
+    if (motion_frame_output)
+    {
+        motion_frame_output->render->rem_effect(&on_motion_frame);
+        motion_frame_output = nullptr;
+    }
+}
+
 void wf::cursor_t::init_xcursor()
 {
     std::string theme = wf::option_wrapper_t<std::string>("input/cursor_theme");
@@ -241,5 +373,6 @@ void wf::cursor_t::set_touchscreen_mode(bool enabled)
 
 wf::cursor_t::~cursor_t()
 {
+    stop_motion_frames();
     wf::get_core().disconnect_signal("reload-config", &config_reloaded);
 }
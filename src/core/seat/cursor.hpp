@@ -2,8 +2,10 @@
 #define CURSOR_HPP
 
 #include "seat.hpp"
+#include "motion-coalescer.hpp"
 #include "wayfire/plugin.hpp"
 #include "wayfire/util.hpp"
+#include "wayfire/render-manager.hpp"
 
 namespace wf
 {
@@ -66,6 +68,34 @@ struct cursor_t
     wf::signal_callback_t config_reloaded;
     wf::seat_t *seat;
 
+    /**
+     * With input/coalesce_pointer_motion, the relative motion events received
+     * between two frames of the output under the cursor are summed up and
+     * processed once, at the start of the frame: the pointer_motion signals
+     * are emitted, the cursor moves and the focus is updated only then.
+     *
+     * The first motion after a pause is processed right away. Pending motion
+     * is processed before any other pointer or tablet event, and every event
+     * is processed while a pointer constraint is active.
+     */
+    wf::option_wrapper_t<bool> coalesce_motion{"input/coalesce_pointer_motion"};
+    wf::motion_coalescer_t motion_coalescer;
+    /** The output whose frames are used to process the pending motion */
+    wf::output_t *motion_frame_output = nullptr;
+    wf::effect_hook_t on_motion_frame;
+    wf::signal_connection_t on_output_removed;
+
+    /** Process or postpone a relative motion event */
+    void handle_pointer_motion(wlr_event_pointer_motion *ev);
+    /** Emit the pointer_motion signals and let the pointer process it */
+    void process_pointer_motion(wlr_event_pointer_motion *ev);
+    void process_pointer_motion(const wf::pointer_motion_t& motion);
+    /** Process the postponed motion, if any */
+    void flush_pending_motion();
+    /** Request a frame of the output under the cursor */
+    void schedule_motion_frame();
+    void stop_motion_frames();
+
     wlr_cursor *cursor = NULL;
     wlr_xcursor_manager *xcursor = NULL;
 
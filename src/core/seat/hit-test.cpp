@@ -0,0 +1,110 @@
+#include "hit-test.hpp"
+#include "input-manager.hpp"
+#include "../core-impl.hpp"
+#include "../../view/surface-impl.hpp"
+#include <wayfire/output.hpp>
+#include <wayfire/workspace-manager.hpp>
+#include <cmath>
+
+wf::hit_test_cache_t::hit_test_cache_t()
+{
+    on_view_geometry_changed.set_callback([=] (wf::signal_data_t*)
+    {
+        valid = false;
+    });
+    wf::get_core().connect_signal("view-geometry-changed",
+        &on_view_geometry_changed);
+}
+
+bool wf::hit_test_cache_t::is_valid(wf::output_t *output) const
+{
+    return valid &&
+           (stack_generation == output->workspace->get_stack_generation()) &&
+           (input_serial == wf::surface_interface_t::impl::input_serial) &&
+           (exclusive_client == wf::get_core_impl().input->exclusive_client);
+}
+
+void wf::hit_test_cache_t::rebuild(wf::output_t *output)
+{
+    auto& input = wf::get_core_impl().input;
+
+    entries.clear();
+    for (auto& v :
+         output->workspace->get_views_in_layer_span(wf::VISIBLE_LAYERS))
+    {
+        v->for_each_view([&] (wayfire_view view)
+        {
+            if (view->minimized || !view->is_visible() || !view->is_mapped() ||
+                !input->can_focus_surface(view.get()))
+            {
+                return;
+            }
+
+            /* The point has to be mapped through the transformers, so the
+             * view is checked as a whole */
+            if (view->has_transformer())
+            {
+                entries.push_back({view.get(), nullptr, view->get_bounding_box()});
+                return;
+            }
+
+            auto origin = wf::origin(view->get_output_geometry());
+            view->for_each_surface([&] (const wf::surface_iterator_t& child)
+            {
+                auto size = child.surface->get_size();
+                entries.push_back({view.get(), child.surface,
+                    {child.position.x, child.position.y, size.width, size.height}
+                });
+            }, origin);
+        });
+    }
+
+    valid = true;
+    stack_generation = output->workspace->get_stack_generation();
+    input_serial     = wf::surface_interface_t::impl::input_serial;
+    exclusive_client = input->exclusive_client;
+}
+
+wf::surface_interface_t*wf::hit_test_cache_t::surface_at(wf::output_t *output,
+    wf::pointf_t point, wf::pointf_t& local)
+{
+    if (!is_valid(output))
+    {
+        rebuild(output);
+    }
+
+    return find_surface(entries, point, local);
+}
+
+wf::surface_interface_t*wf::hit_test_cache_t::find_surface(
+    const std::vector<entry_t>& entries, wf::pointf_t point, wf::pointf_t& local)
+{
+    for (auto& entry : entries)
+    {
+        if (!entry.surface)
+        {
+            auto surface = entry.view->map_input_coordinates(point, local);
+            if (surface)
+            {
+                return surface;
+            }
+
+            continue;
+        }
+
+        /* Surfaces never accept input outside of their size */
+        if (!(entry.box & point))
+        {
+            continue;
+        }
+
+        local.x = point.x - entry.box.x;
+        local.y = point.y - entry.box.y;
+        if (entry.surface->accepts_input(std::floor(local.x), std::floor(local.y)))
+        {
+            return entry.surface;
+        }
+    }
+
+    return nullptr;
+}
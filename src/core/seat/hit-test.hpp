@@ -0,0 +1,84 @@
+#ifndef WF_SEAT_HIT_TEST_HPP
+#define WF_SEAT_HIT_TEST_HPP
+
+#include <wayfire/object.hpp>
+#include <wayfire/surface.hpp>
+#include <wayfire/view.hpp>
+#include <vector>
+
+namespace wf
+{
+/**
+ * A flat list of the surfaces on an output which can receive input, from the
+ * topmost to the bottommost, with their boxes in output-local coordinates.
+ *
+ * Finding the surface at a point then needs only to compare the point with
+ * the boxes, and check the input region of the surfaces which contain it,
+ * instead of enumerating all views and their surfaces and mapping the point
+ * through their transformers.
+ *
+ * The list is rebuilt lazily, whenever the stacking order changes, views move
+ * or change their size, the current workspace changes, or the size of a
+ * surface or the position of a subsurface changes (see
+ * update_input_serial()). Damage and commits which only change the contents
+ * of surfaces keep the list. Input regions are not part of the list, they are
+ * queried from the surfaces. Views with transformers are kept as a single
+ * entry which is checked with view_interface_t::map_input_coordinates().
+ *
+ * The hit-test cache of an output is stored as custom data of the output.
+ */
+class hit_test_cache_t : public wf::custom_data_t
+{
+  public:
+    hit_test_cache_t();
+
+    /**
+     * Find the surface which accepts input at the given point.
+     *
+     * @param output The output of the cache.
+     * @param point The point in output-local coordinates.
+     * @param local Set to the surface-local coordinates of the point.
+     *
+     * @return The surface at the point, or nullptr.
+     */
+    wf::surface_interface_t *surface_at(wf::output_t *output,
+        wf::pointf_t point, wf::pointf_t& local);
+
+    struct entry_t
+    {
+        /* The view the surface belongs to */
+        wf::view_interface_t *view;
+        /* The surface, or nullptr if the view has transformers */
+        wf::surface_interface_t *surface;
+        /* The box of the surface, in output-local coordinates */
+        wf::geometry_t box;
+    };
+
+    /**
+     * Find the first entry which accepts input at the given point, see
+     * surface_at().
+     */
+    static wf::surface_interface_t *find_surface(
+        const std::vector<entry_t>& entries, wf::pointf_t point,
+        wf::pointf_t& local);
+
+  private:
+    std::vector<entry_t> entries;
+
+    /* The state the entries were built for */
+    bool valid = false;
+    uint64_t stack_generation = 0;
+    uint64_t input_serial     = 0;
+    wl_client *exclusive_client = nullptr;
+
+    /* Views which are not in the layers of an output, like child views, do
+     * not change the stack generation when they move */
+    wf::signal_connection_t on_view_geometry_changed;
+
+    /** @return true if the entries are still up to date */
+    bool is_valid(wf::output_t *output) const;
+    void rebuild(wf::output_t *output);
+};
+}
+
+#endif /* end of include guard: WF_SEAT_HIT_TEST_HPP */
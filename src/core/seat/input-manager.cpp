@@ -8,6 +8,7 @@
 #include "touch.hpp"
 #include "keyboard.hpp"
 #include "cursor.hpp"
+#include "hit-test.hpp"
 #include "input-manager.hpp"
 #include "wayfire/output-layout.hpp"
 #include "wayfire/workspace-manager.hpp"
@@ -270,23 +271,8 @@ wf::surface_interface_t*wf::input_manager_t::input_surface_at(
     global.x -= og.x;
     global.y -= og.y;
 
-    for (auto& v : output->workspace->get_views_in_layer(wf::VISIBLE_LAYERS))
-    {
-        for (auto& view : v->enumerate_views())
-        {
-            if (!view->minimized && view->is_visible() &&
-                can_focus_surface(view.get()))
-            {
-                auto surface = view->map_input_coordinates(global, local);
-                if (surface)
-                {
-                    return surface;
-                }
-            }
-        }
-    }
-
-    return nullptr;
+    return output->get_data_safe<wf::hit_test_cache_t>()->surface_at(output,
+        global, local);
 }
 
 void wf::input_manager_t::set_exclusive_focus(wl_client *client)
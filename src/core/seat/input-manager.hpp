@@ -91,7 +91,7 @@ class input_manager_t
  */
 template<class EventType>
 wf::input_event_processing_mode_t emit_device_event_signal(
-    std::string event_name, EventType *event)
+    const wf::signal_id_t& event_name, EventType *event)
 {
     wf::input_event_signal<EventType> data;
     data.event = event;
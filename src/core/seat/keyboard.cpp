@@ -13,6 +13,9 @@
 #include "wayfire/compositor-view.hpp"
 #include "wayfire/signal-definitions.hpp"
 
+static const wf::signal_id_t key_id{"keyboard_key"};
+static const wf::signal_id_t key_post_id{"keyboard_key_post"};
+
 void wf::keyboard_t::setup_listeners()
 {
     on_config_reload.set_callback([&] (signal_data_t*)
@@ -24,7 +27,7 @@ void wf::keyboard_t::setup_listeners()
     on_key.set_callback([&] (void *data)
     {
         auto ev   = static_cast<wlr_event_keyboard_key*>(data);
-        auto mode = emit_device_event_signal("keyboard_key", ev);
+        auto mode = emit_device_event_signal(key_id, ev);
 
         auto& seat = wf::get_core_impl().seat;
         seat->set_keyboard(this);
@@ -37,7 +40,7 @@ void wf::keyboard_t::setup_listeners()
         }
 
         wlr_idle_notify_activity(wf::get_core().protocols.idle, seat->seat);
-        emit_device_event_signal("keyboard_key_post", ev);
+        emit_device_event_signal(key_post_id, ev);
     });
 
     on_modifier.set_callback([&] (void *data)
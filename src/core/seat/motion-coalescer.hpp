@@ -0,0 +1,136 @@
+#ifndef WF_SEAT_MOTION_COALESCER_HPP
+#define WF_SEAT_MOTION_COALESCER_HPP
+
+#include <cstdint>
+#include <optional>
+
+namespace wf
+{
+/** A relative pointer motion, possibly the sum of several motion events */
+struct pointer_motion_t
+{
+    /** The device which generated the motion */
+    void *device = nullptr;
+    /** The time of the last folded event */
+    uint32_t time_msec = 0;
+    double delta_x     = 0;
+    double delta_y     = 0;
+    double unaccel_dx  = 0;
+    double unaccel_dy  = 0;
+};
+
+/**
+ * Folds the relative pointer motion events received between two frames into a
+ * single motion.
+ *
+ * The first motion after a pause is processed right away and starts waiting
+ * for a frame. Motion received until the frame is summed up and processed
+ * once at the frame. A frame without any pending motion ends the waiting, so
+ * the next motion is again processed right away.
+ *
+ * Motion from different devices is never folded together.
+ */
+class motion_coalescer_t
+{
+  public:
+    /** Statistics about the coalesced motion since startup */
+    struct stats_t
+    {
+        /** Number of motion events received */
+        uint64_t received = 0;
+        /** Number of motion events folded into another one */
+        uint64_t folded = 0;
+    };
+
+    /**
+     * Add a motion event.
+     *
+     * @return The motion which has to be processed right away, if any. This
+     *   is either the given motion, if no frame was awaited, or the pending
+     *   motion of another device.
+     */
+    std::optional<pointer_motion_t> add(const pointer_motion_t& motion)
+    {
+        stats.received++;
+        if (!waiting_frame)
+        {
+            waiting_frame = true;
+            return motion;
+        }
+
+        if (!pending)
+        {
+            pending = motion;
+            return {};
+        }
+
+        if (pending->device != motion.device)
+        {
+            auto other = pending;
+            pending = motion;
+            return other;
+        }
+
+        stats.folded++;
+        pending->time_msec   = motion.time_msec;
+        pending->delta_x    += motion.delta_x;
+        pending->delta_y    += motion.delta_y;
+        pending->unaccel_dx += motion.unaccel_dx;
+        pending->unaccel_dy += motion.unaccel_dy;
+
+        return {};
+    }
+
+    /**
+     * Handle a frame.
+     *
+     * @return The pending motion, if any. If there is none, the coalescer
+     *   stops waiting for frames.
+     */
+    std::optional<pointer_motion_t> frame()
+    {
+        if (!pending)
+        {
+            waiting_frame = false;
+        }
+
+        return take();
+    }
+
+    /** @return The pending motion, if any, which is then no longer pending */
+    std::optional<pointer_motion_t> take()
+    {
+        auto motion = pending;
+        pending.reset();
+        return motion;
+    }
+
+    /**
+     * Stop waiting for a frame, for ex. because the output went away. The
+     * pending motion is dropped, so it should be taken before.
+     */
+    void reset()
+    {
+        pending.reset();
+        waiting_frame = false;
+    }
+
+    /** @return Whether a frame is awaited */
+    bool is_waiting_frame() const
+    {
+        return waiting_frame;
+    }
+
+    const stats_t& get_stats() const
+    {
+        return stats;
+    }
+
+  private:
+    std::optional<pointer_motion_t> pending;
+    bool waiting_frame = false;
+    stats_t stats;
+};
+}
+
+#endif /* end of include guard: WF_SEAT_MOTION_COALESCER_HPP */
@@ -41,6 +41,13 @@ bool wf::pointer_t::has_pressed_buttons() const
     return this->count_pressed_buttons > 0;
 }
 
+bool wf::pointer_t::can_coalesce_motion() const
+{
+    /* A confined or locked pointer depends on the exact focus at every
+     * event */
+    return this->active_pointer_constraint == nullptr;
+}
+
 /* ------------------------- Cursor focus functions ------------------------- */
 void wf::pointer_t::set_enable_focus(bool enabled)
 {
@@ -201,14 +208,14 @@ wf::pointf_t wf::pointer_t::get_absolute_position_from_relative(
     auto output_geometry = view->get_output_geometry();
     wf::point_t origin   = {output_geometry.x, output_geometry.y};
 
-    for (auto& surf : view->enumerate_surfaces(origin))
+    view->for_each_surface([&] (const wf::surface_iterator_t& surf)
     {
         if (surf.surface == this->cursor_focus)
         {
             relative.x += surf.position.x;
             relative.y += surf.position.y;
         }
-    }
+    }, origin);
 
     relative = view->transform_point(relative);
     auto output = view->get_output()->get_layout_geometry();
@@ -92,6 +92,12 @@ class pointer_t
     /** Whether there are pressed buttons currently */
     bool has_pressed_buttons() const;
 
+    /**
+     * @return Whether relative motion may be processed once per frame instead
+     *   of at every event, see cursor_t.
+     */
+    bool can_coalesce_motion() const;
+
   private:
     nonstd::observer_ptr<wf::input_manager_t> input;
     nonstd::observer_ptr<seat_t> seat;
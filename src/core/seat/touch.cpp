@@ -11,6 +11,13 @@
 #include "wayfire/compositor-surface.hpp"
 #include "wayfire/output-layout.hpp"
 
+static const wf::signal_id_t down_id{"touch_down"};
+static const wf::signal_id_t down_post_id{"touch_down_post"};
+static const wf::signal_id_t up_id{"touch_up"};
+static const wf::signal_id_t up_post_id{"touch_up_post"};
+static const wf::signal_id_t motion_id{"touch_motion"};
+static const wf::signal_id_t motion_post_id{"touch_motion_post"};
+
 wf::touch_interface_t::touch_interface_t(wlr_cursor *cursor, wlr_seat *seat,
     input_surface_selector_t surface_at)
 {
@@ -22,7 +29,7 @@ wf::touch_interface_t::touch_interface_t(wlr_cursor *cursor, wlr_seat *seat,
     on_down.set_callback([=] (void *data)
     {
         auto ev   = static_cast<wlr_event_touch_down*>(data);
-        auto mode = emit_device_event_signal("touch_down", ev);
+        auto mode = emit_device_event_signal(down_id, ev);
 
         double lx, ly;
         wlr_cursor_absolute_to_layout_coords(cursor, ev->device,
@@ -33,23 +40,23 @@ wf::touch_interface_t::touch_interface_t(wlr_cursor *cursor, wlr_seat *seat,
         handle_touch_down(ev->touch_id, ev->time_msec, point, mode);
         wlr_idle_notify_activity(wf::get_core().protocols.idle,
             wf::get_core().get_current_seat());
-        emit_device_event_signal("touch_down_post", ev);
+        emit_device_event_signal(down_post_id, ev);
     });
 
     on_up.set_callback([=] (void *data)
     {
         auto ev   = static_cast<wlr_event_touch_up*>(data);
-        auto mode = emit_device_event_signal("touch_up", ev);
+        auto mode = emit_device_event_signal(up_id, ev);
         handle_touch_up(ev->touch_id, ev->time_msec, mode);
         wlr_idle_notify_activity(wf::get_core().protocols.idle,
             wf::get_core().get_current_seat());
-        emit_device_event_signal("touch_up_post", ev);
+        emit_device_event_signal(up_post_id, ev);
     });
 
     on_motion.set_callback([=] (void *data)
     {
         auto ev   = static_cast<wlr_event_touch_motion*>(data);
-        auto mode = emit_device_event_signal("touch_motion", ev);
+        auto mode = emit_device_event_signal(motion_id, ev);
 
         double lx, ly;
         wlr_cursor_absolute_to_layout_coords(
@@ -61,7 +68,7 @@ wf::touch_interface_t::touch_interface_t(wlr_cursor *cursor, wlr_seat *seat,
         handle_touch_motion(ev->touch_id, ev->time_msec, point, true, mode);
         wlr_idle_notify_activity(wf::get_core().protocols.idle,
             wf::get_core().get_current_seat());
-        emit_device_event_signal("touch_motion_post", ev);
+        emit_device_event_signal(motion_post_id, ev);
     });
 
     on_up.connect(&cursor->events.touch_up);
@@ -6,10 +6,11 @@ attribute highp vec2 uvPosition;
 varying highp vec2 uvpos;
 
 uniform mat4 MVP;
+uniform highp vec4 uvBox;
 
 void main() {
     gl_Position = MVP * vec4(position.xy, 0.0, 1.0);
-    uvpos = uvPosition;
+    uvpos = mix(uvBox.xy, uvBox.zw, uvPosition);
 })";
 
 static const char *default_fragment_shader_source =
@@ -188,6 +188,21 @@ void parse_extended_debugging(const std::vector<std::string>& categories)
             LOGD("Enabling extended debugging for wlroots");
             wf::log::enabled_categories.set(
                 (size_t)wf::log::logging_category::WLR, 1);
+        } else if (cat == "render")
+        {
+            LOGD("Enabling extended debugging for repaint timings");
+            wf::log::enabled_categories.set(
+                (size_t)wf::log::logging_category::RENDER, 1);
+        } else if (cat == "gpumem")
+        {
+            LOGD("Enabling extended debugging for GPU memory usage");
+            wf::log::enabled_categories.set(
+                (size_t)wf::log::logging_category::GPUMEM, 1);
+        } else if (cat == "input")
+        {
+            LOGD("Enabling extended debugging for pointer motion coalescing");
+            wf::log::enabled_categories.set(
+                (size_t)wf::log::logging_category::INPUT, 1);
         } else
         {
             LOGE("Unrecognized debugging category \"", cat, "\"");
@@ -0,0 +1,529 @@
+#ifndef WF_LAYER_MANAGER_HPP
+#define WF_LAYER_MANAGER_HPP
+
+#include <wayfire/view.hpp>
+#include <wayfire/workspace-manager.hpp>
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "../view/view-impl.hpp"
+
+namespace wf
+{
+/** Find a smart pointer inside a list */
+template<class Haystack, class Needle>
+typename std::list<Haystack>::iterator find_in(std::list<Haystack>& hay,
+    const Needle& needle)
+{
+    return std::find_if(std::begin(hay), std::end(hay), [=] (const auto& elem)
+    {
+        return elem.get() == needle.get();
+    });
+}
+
+/** Bring to front or lower to back inside a container of smart pointers */
+template<class Haystack, class Needle>
+void raise_to_front(std::list<Haystack>& hay, const Needle& needle,
+    bool reverse = false)
+{
+    auto it = find_in(hay, needle);
+    hay.splice(reverse ? hay.end() : hay.begin(), hay, it);
+}
+
+/** Reorder list so that @element is directly above @below. */
+template<class Haystack, class Needle>
+void reorder_above(
+    std::list<Haystack>& list, const Needle& element, const Needle& below)
+{
+    auto element_it = find_in(list, element);
+    auto pos = find_in(list, below);
+    list.splice(pos, list, element_it);
+}
+
+/** Reorder list so that @element is directly below @above. */
+template<class Haystack, class Needle>
+void reorder_below(
+    std::list<Haystack>& list, const Needle& element, const Needle& above)
+{
+    auto element_it = find_in(list, element);
+    auto pos = find_in(list, above);
+    assert(pos != list.end());
+    list.splice(std::next(pos), list, element_it);
+}
+
+/**
+ * Remove needle from haystack, where both needle and elements in haystack are
+ * smart pointers.
+ */
+template<class Haystack, class Needle>
+void remove_from(Haystack& haystack, Needle& n)
+{
+    auto it = std::remove_if(std::begin(haystack), std::end(haystack),
+        [=] (const auto& contained)
+    {
+        return contained.get() == n.get();
+    });
+
+    haystack.erase(it, std::end(haystack));
+}
+
+/** Damage the entire view tree including the view itself. */
+inline void damage_views(wayfire_view view)
+{
+    view->for_each_view([] (wayfire_view view)
+    {
+        view->damage();
+    }, false);
+}
+
+struct layer_container_t;
+/**
+ * Implementation of the sublayer struct.
+ */
+struct sublayer_t
+{
+    /** A list of the views in the sublayer */
+    std::list<wayfire_view> views;
+
+    /** The actual layer this sublayer belongs to */
+    nonstd::observer_ptr<layer_container_t> layer;
+
+    /** The sublayer mode */
+    sublayer_mode_t mode;
+
+    /**
+     * Whether the sublayer is created artificially to hold a single view.
+     * In those cases, the sublayer is destroyed as soon as the view is moved
+     * elsewhere.
+     */
+    bool is_single_view;
+};
+
+/**
+ * A container for all the sublayers of a layer.
+ */
+struct layer_container_t
+{
+    /** The layer of the container */
+    layer_t layer;
+
+    using sublayer_container_t = std::list<std::unique_ptr<sublayer_t>>;
+    /** List of sublayers docked below */
+    sublayer_container_t below;
+    /** List of floating sublayers */
+    sublayer_container_t floating;
+    /** List of sublayers docked above */
+    sublayer_container_t above;
+
+    void remove_sublayer(nonstd::observer_ptr<sublayer_t> sublayer)
+    {
+        for (auto container : {& below, & floating, & above})
+        {
+            remove_from(*container, sublayer);
+        }
+    }
+};
+
+/**
+ * output_layer_manager_t is a part of the workspace_manager module. It provides
+ * the functionality related to layers and sublayers.
+ */
+class output_layer_manager_t
+{
+    // A hierarchical representation of the view stack order
+    layer_container_t layers[TOTAL_LAYERS];
+
+    /** A flat representation of the stack order of the views in some layers */
+    struct stack_snapshot_t
+    {
+        /* The stack generation the snapshot was taken at */
+        uint64_t generation = 0;
+        std::shared_ptr<std::vector<wayfire_view>> views;
+    };
+
+    // Snapshots of the view stack order, by layer mask, built on demand
+    std::unordered_map<uint32_t, stack_snapshot_t> stack_snapshots;
+    // Incremented whenever the stack order changes
+    uint64_t stack_generation = 1;
+    // Incremented whenever views move, see views_moved()
+    uint64_t moves_generation = 0;
+
+    // Positions of the views in the stack order of all layers
+    std::unordered_map<view_interface_t*, size_t> stack_positions;
+    uint64_t stack_positions_generation = 0;
+
+  public:
+    output_layer_manager_t()
+    {
+        for (int i = 0; i < TOTAL_LAYERS; i++)
+        {
+            layers[i].layer = static_cast<layer_t>(1 << i);
+        }
+    }
+
+    constexpr int layer_index_from_mask(uint32_t layer_mask) const
+    {
+        return __builtin_ctz(layer_mask);
+    }
+
+    nonstd::observer_ptr<sublayer_t>& get_view_sublayer(wayfire_view view)
+    {
+        return view->view_impl->sublayer;
+    }
+
+    uint32_t get_view_layer(wayfire_view view)
+    {
+        /*
+         * A view might have layer data set from a previous output.
+         * That does not mean it has an assigned layer.
+         */
+        auto sublayer = get_view_sublayer(view);
+        if (!sublayer)
+        {
+            return 0;
+        }
+
+        return sublayer->layer->layer;
+    }
+
+    void remove_view(wayfire_view view)
+    {
+        auto& sublayer = get_view_sublayer(view);
+        if (!sublayer)
+        {
+            return;
+        }
+
+        damage_views(view);
+
+        remove_from(sublayer->views, view);
+        if (sublayer->is_single_view)
+        {
+            sublayer->layer->remove_sublayer(sublayer);
+        }
+
+        /* Reset the view's sublayer */
+        sublayer = nullptr;
+        rebuild_stack_order();
+    }
+
+    void add_view_to_sublayer(wayfire_view view,
+        nonstd::observer_ptr<sublayer_t> sublayer)
+    {
+        remove_view(view);
+        get_view_sublayer(view) = sublayer;
+        sublayer->views.push_front(view);
+        rebuild_stack_order();
+    }
+
+    nonstd::observer_ptr<sublayer_t> create_sublayer(layer_t layer_mask,
+        sublayer_mode_t mode)
+    {
+        auto sublayer = std::make_unique<sublayer_t>();
+        nonstd::observer_ptr<sublayer_t> ptr{sublayer};
+
+        auto& layer = this->layers[layer_index_from_mask(layer_mask)];
+        sublayer->layer = &layer;
+        sublayer->mode  = mode;
+        sublayer->is_single_view = false;
+
+        switch (mode)
+        {
+          case SUBLAYER_DOCKED_BELOW:
+            layer.below.emplace_back(std::move(sublayer));
+            break;
+
+          case SUBLAYER_DOCKED_ABOVE:
+            layer.above.emplace_front(std::move(sublayer));
+            break;
+
+          case SUBLAYER_FLOATING:
+            layer.floating.emplace_front(std::move(sublayer));
+            break;
+        }
+
+        return ptr;
+    }
+
+    /** Add or move the view to the given layer */
+    void add_view_to_layer(wayfire_view view, layer_t layer)
+    {
+        damage_views(view);
+        add_view_to_sublayer(view, create_sublayer(layer, SUBLAYER_FLOATING));
+        rebuild_stack_order();
+        damage_views(view);
+    }
+
+    /** Precondition: view is in some sublayer */
+    void bring_to_front(wayfire_view view)
+    {
+        auto sublayer = get_view_sublayer(view);
+        assert(sublayer);
+
+        for (auto view : sublayer->views)
+        {
+            damage_views(view);
+        }
+
+        if (sublayer->mode == SUBLAYER_FLOATING)
+        {
+            raise_to_front(sublayer->layer->floating, sublayer);
+        }
+
+        raise_to_front(sublayer->views, view);
+        rebuild_stack_order();
+    }
+
+    wayfire_view get_front_view(wf::layer_t layer)
+    {
+        auto views = get_stack_snapshot(layer);
+        if (views->empty())
+        {
+            return nullptr;
+        }
+
+        return views->front();
+    }
+
+    /** Precondition: view and below are in the same layer */
+    void restack_above(wayfire_view view, wayfire_view below)
+    {
+        damage_views(view);
+
+        auto view_sublayer  = get_view_sublayer(view);
+        auto below_sublayer = get_view_sublayer(below);
+        assert(view_sublayer->layer == below_sublayer->layer);
+
+        if (view_sublayer == below_sublayer)
+        {
+            reorder_above(view_sublayer->views, view, below);
+            rebuild_stack_order();
+
+            return;
+        }
+
+        if ((view_sublayer->mode != SUBLAYER_FLOATING) ||
+            (below_sublayer->mode != SUBLAYER_FLOATING))
+        {
+            return;
+        }
+
+        reorder_above(view_sublayer->layer->floating, view_sublayer, below_sublayer);
+        raise_to_front(view_sublayer->views, view, true); // bring to back == reverse
+        rebuild_stack_order();
+    }
+
+    /** Precondition: view and above are in the same layer */
+    void restack_below(wayfire_view view, wayfire_view above)
+    {
+        damage_views(view);
+
+        auto view_sublayer  = get_view_sublayer(view);
+        auto above_sublayer = get_view_sublayer(above);
+        assert(view_sublayer->layer == above_sublayer->layer);
+
+        if (view_sublayer == above_sublayer)
+        {
+            reorder_below(view_sublayer->views, view, above);
+            rebuild_stack_order();
+
+            return;
+        }
+
+        if ((view_sublayer->mode != SUBLAYER_FLOATING) ||
+            (above_sublayer->mode != SUBLAYER_FLOATING))
+        {
+            return;
+        }
+
+        reorder_below(view_sublayer->layer->floating, view_sublayer, above_sublayer);
+        raise_to_front(view_sublayer->views, view);
+        rebuild_stack_order();
+    }
+
+    enum class promoted_state_t
+    {
+        PROMOTED,
+        NOT_PROMOTED,
+        ANY,
+    };
+
+    void push_views(std::vector<wayfire_view>& into, layer_t layer_e,
+        promoted_state_t desired_promoted)
+    {
+        auto& layer = this->layers[layer_index_from_mask(layer_e)];
+        for (const auto& sublayers :
+             {& layer.above, & layer.floating, & layer.below})
+        {
+            for (const auto& sublayer : *sublayers)
+            {
+                auto& container = sublayer->views;
+                std::copy_if(container.begin(), container.end(),
+                    std::back_inserter(into), [=] (wayfire_view view)
+                {
+                    if (desired_promoted == promoted_state_t::ANY)
+                    {
+                        return true;
+                    }
+
+                    const bool wants_promoted =
+                        (desired_promoted == promoted_state_t::PROMOTED);
+                    return view->view_impl->is_promoted == wants_promoted;
+                });
+            }
+        }
+    }
+
+    /** Invalidate the snapshots of the stack order */
+    void rebuild_stack_order()
+    {
+        ++stack_generation;
+    }
+
+    /**
+     * Note that views have moved or the current workspace has changed. The
+     * stack order stays the same, but the generation is incremented.
+     */
+    void views_moved()
+    {
+        ++moves_generation;
+    }
+
+    /** See workspace_manager::get_stack_generation() */
+    uint64_t get_stack_generation() const
+    {
+        return stack_generation + moves_generation;
+    }
+
+    std::vector<wayfire_view> get_views_in_layer(uint32_t layers_mask)
+    {
+        return *get_stack_snapshot(layers_mask);
+    }
+
+    /**
+     * @return The position of the view in the stack order of all layers, the
+     *   topmost view is at position 0. Views which are in no layer are at
+     *   position SIZE_MAX.
+     */
+    size_t get_stack_position(wayfire_view view)
+    {
+        if (stack_positions_generation != stack_generation)
+        {
+            auto views = get_stack_snapshot(ALL_LAYERS);
+            stack_positions.clear();
+            for (size_t i = 0; i < views->size(); i++)
+            {
+                stack_positions[(*views)[i].get()] = i;
+            }
+
+            stack_positions_generation = stack_generation;
+        }
+
+        auto it = stack_positions.find(view.get());
+        return it == stack_positions.end() ? SIZE_MAX : it->second;
+    }
+
+    /**
+     * Get the snapshot of the stack order for the given layers, rebuilding it
+     * if the stack order changed since it was taken.
+     */
+    std::shared_ptr<const std::vector<wayfire_view>> get_stack_snapshot(
+        uint32_t layers_mask)
+    {
+        auto& snapshot = stack_snapshots[layers_mask];
+        if (snapshot.views && (snapshot.generation == stack_generation))
+        {
+            return snapshot.views;
+        }
+
+        if (!snapshot.views || (snapshot.views.use_count() > 1))
+        {
+            /* The old snapshot is still in use by a view_span_t */
+            snapshot.views = std::make_shared<std::vector<wayfire_view>>();
+        } else
+        {
+            /* Reuse the memory of the old snapshot */
+            snapshot.views->clear();
+        }
+
+        _get_views_in_layer(*snapshot.views, layers_mask);
+        snapshot.generation = stack_generation;
+        return snapshot.views;
+    }
+
+    void _get_views_in_layer(std::vector<wayfire_view>& views,
+        uint32_t layers_mask)
+    {
+        auto try_push = [&] (layer_t layer,
+                             promoted_state_t state = promoted_state_t::ANY)
+        {
+            if (!(layer & layers_mask))
+            {
+                return;
+            }
+
+            push_views(views, layer, state);
+        };
+
+        /* Above fullscreen views */
+        for (auto layer : {LAYER_DESKTOP_WIDGET, LAYER_LOCK, LAYER_UNMANAGED})
+        {
+            try_push(layer);
+        }
+
+        /* Fullscreen */
+        try_push(LAYER_WORKSPACE, promoted_state_t::PROMOTED);
+
+        /* Top layer between fullscreen and workspace */
+        try_push(LAYER_TOP);
+
+        /* Non-promoted views */
+        try_push(LAYER_WORKSPACE, promoted_state_t::NOT_PROMOTED);
+
+        /* Below fullscreen */
+        for (auto layer :
+             {LAYER_BOTTOM, LAYER_BACKGROUND, LAYER_MINIMIZED})
+        {
+            try_push(layer);
+        }
+    }
+
+    std::vector<wayfire_view> get_promoted_views()
+    {
+        std::vector<wayfire_view> views;
+        push_views(views, LAYER_WORKSPACE, promoted_state_t::PROMOTED);
+
+        return views;
+    }
+
+    /**
+     * @return A list of all views in the given sublayer.
+     */
+    std::vector<wayfire_view> get_views_in_sublayer(
+        nonstd::observer_ptr<sublayer_t> sublayer)
+    {
+        std::vector<wayfire_view> result;
+        std::copy(sublayer->views.begin(), sublayer->views.end(),
+            std::back_inserter(result));
+
+        return result;
+    }
+
+    void destroy_sublayer(nonstd::observer_ptr<sublayer_t> sublayer)
+    {
+        for (auto& view : get_views_in_sublayer(sublayer))
+        {
+            add_view_to_layer(view, sublayer->layer->layer);
+        }
+
+        sublayer->layer->remove_sublayer(sublayer);
+    }
+};
+}
+
+#endif /* end of include guard: WF_LAYER_MANAGER_HPP */
@@ -1,5 +1,6 @@
 #include "wayfire/render-manager.hpp"
 #include "view/view-impl.hpp"
+#include "view/snapshot-cache.hpp"
 #include "wayfire/signal-definitions.hpp"
 #include "wayfire/workspace-stream.hpp"
 #include "wayfire/output.hpp"
@@ -8,10 +9,16 @@
 #include "wayfire/workspace-manager.hpp"
 #include "../core/seat/seat.hpp"
 #include "../core/opengl-priv.hpp"
+#include "../core/framebuffer-pool.hpp"
 #include "../main.hpp"
 #include <algorithm>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <map>
+#include <wayfire/debug.hpp>
 #include <wayfire/nonstd/reverse.hpp>
-#include <wayfire/nonstd/safe-list.hpp>
+#include <wayfire/nonstd/safe-vector.hpp>
 #include <wayfire/util/log.hpp>
 #include <wayfire/nonstd/wlroots-full.hpp>
 
@@ -53,6 +60,7 @@ struct output_damage_t
         /* Wlroots expects damage after scaling */
         auto scaled_region = region * wo->handle->scale;
         frame_damage |= scaled_region;
+        frame_damage_coalesced = false;
         wlr_output_damage_add(damage_manager, scaled_region.to_pixman());
     }
 
@@ -66,11 +74,34 @@ struct output_damage_t
         /* Wlroots expects damage after scaling */
         auto scaled_box = box * wo->handle->scale;
         frame_damage |= scaled_box;
+        frame_damage_coalesced = false;
         wlr_output_damage_add_box(damage_manager, &scaled_box);
     }
 
     wf::region_t acc_damage;
 
+    wf::option_wrapper_t<int> coalesce_threshold{"core/damage_coalesce_threshold"};
+    wf::option_wrapper_t<int> coalesce_waste{"core/damage_coalesce_waste"};
+
+    /* Whether frame_damage has been coalesced since it last changed */
+    bool frame_damage_coalesced = false;
+
+    /**
+     * Merge the rectangles of a fragmented frame damage, so that the damage
+     * can be repainted with fewer draw calls.
+     */
+    void coalesce_frame_damage()
+    {
+        if (frame_damage_coalesced)
+        {
+            return;
+        }
+
+        frame_damage_coalesced = true;
+        frame_damage.coalesce(std::max(0, (int)coalesce_threshold),
+            std::clamp((int)coalesce_waste, 0, 100) / 100.0);
+    }
+
     /**
      * Make the output current. This sets its EGL context as current, checks
      * whether there is any damage and makes sure frame_damage contains all the
@@ -104,6 +135,7 @@ struct output_damage_t
     void accumulate_damage()
     {
         frame_damage |= acc_damage;
+        frame_damage_coalesced = false;
         if (runtime_config.no_damage_track)
         {
             frame_damage |= get_wlr_damage_box();
@@ -121,6 +153,7 @@ struct output_damage_t
             return {};
         }
 
+        coalesce_frame_damage();
         return frame_damage * (1.0 / wo->handle->scale);
     }
 
@@ -147,6 +180,7 @@ struct output_damage_t
             const_cast<wf::region_t&>(swap_damage).to_pixman());
         wlr_output_commit(output);
         frame_damage.clear();
+        frame_damage_coalesced = false;
     }
 
     bool force_next_frame = false;
@@ -191,11 +225,30 @@ struct output_damage_t
      */
     wf::region_t get_ws_damage(wf::point_t ws)
     {
+        coalesce_frame_damage();
         auto scaled = frame_damage * (1.0 / wo->handle->scale);
 
         return scaled & get_ws_box(ws);
     }
 
+    /**
+     * Same as get_ws_damage(), but stores the result in @result, reusing its
+     * storage if possible.
+     */
+    void get_ws_damage(wf::point_t ws, wf::region_t& result)
+    {
+        if (wo->handle->scale != 1)
+        {
+            result = get_ws_damage(ws);
+            return;
+        }
+
+        coalesce_frame_damage();
+        auto box = get_ws_box(ws);
+        pixman_region32_intersect_rect(result.to_pixman(),
+            frame_damage.to_pixman(), box.x, box.y, box.width, box.height);
+    }
+
     /**
      * Same as render_manager::damage_whole()
      */
@@ -227,12 +280,260 @@ struct output_damage_t
     }
 };
 
+/**
+ * frame_profiler_t measures how long the individual phases of the repaint
+ * cycle take, as well as the time spent in each effect hook.
+ *
+ * The profiler is active only if the `render` debugging category is enabled
+ * (`wayfire -d render`). In this case, it keeps the last MAX_SAMPLES
+ * measurements in ring buffers, and prints a min/avg/p99 summary of them each
+ * MAX_SAMPLES rendered frames. When the category is disabled, each
+ * measurement point costs a single branch.
+ */
+struct frame_profiler_t
+{
+    enum phase_t
+    {
+        PHASE_PRE_HOOKS    = 0,
+        PHASE_DAMAGE_HOOKS = 1,
+        PHASE_RENDER       = 2,
+        PHASE_OVERLAY      = 3,
+        PHASE_POSTPROCESS  = 4,
+        PHASE_SW_CURSORS   = 5,
+        PHASE_SWAP         = 6,
+        PHASE_FRAME        = 7,
+        PHASE_TOTAL        = 8,
+    };
+
+    static constexpr size_t MAX_SAMPLES = 256;
+
+    /** A fixed-size ring buffer of durations, in nanoseconds. */
+    struct samples_t
+    {
+        std::array<int64_t, MAX_SAMPLES> values;
+        size_t count = 0;
+        size_t next  = 0;
+
+        void push(int64_t value)
+        {
+            values[next] = value;
+            next  = (next + 1) % MAX_SAMPLES;
+            count = std::min(count + 1, MAX_SAMPLES);
+        }
+
+        struct summary_t
+        {
+            int64_t min = 0;
+            int64_t avg = 0;
+            int64_t p99 = 0;
+        };
+
+        summary_t summarize() const
+        {
+            summary_t result;
+            if (count == 0)
+            {
+                return result;
+            }
+
+            auto sorted = values;
+            std::sort(sorted.begin(), sorted.begin() + count);
+
+            int64_t sum = 0;
+            for (size_t i = 0; i < count; i++)
+            {
+                sum += sorted[i];
+            }
+
+            result.min = sorted[0];
+            result.avg = sum / (int64_t)count;
+            result.p99 = sorted[(count - 1) * 99 / 100];
+            return result;
+        }
+    };
+
+    frame_profiler_t(output_t *output)
+    {
+        this->output = output;
+    }
+
+    /** @return Whether measurements are being taken for the current frame. */
+    bool is_active() const
+    {
+        return active;
+    }
+
+    static int64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /** Start measuring a new frame. */
+    void start_frame()
+    {
+        active = wf::log::enabled_categories[
+            (size_t)wf::log::logging_category::RENDER];
+        if (active)
+        {
+            frame_start = last_mark = now();
+        }
+    }
+
+    /** Record the time since the previous mark as the duration of @phase. */
+    void mark(phase_t phase)
+    {
+        if (!active)
+        {
+            return;
+        }
+
+        int64_t current = now();
+        phases[phase].push(current - last_mark);
+        last_mark = current;
+    }
+
+    /** Start tracking an effect hook which is being added. */
+    void register_hook(const effect_hook_t *hook, output_effect_type_t type,
+        const std::string& name)
+    {
+        hooks[{hook, type}].name = name.empty() ? "unnamed" : name;
+    }
+
+    /**
+     * Record the duration of a single effect hook. Hooks which have been
+     * removed in the meantime, for example by themselves, are ignored.
+     */
+    void record_hook(const effect_hook_t *hook, output_effect_type_t type,
+        int64_t duration)
+    {
+        auto it = hooks.find({hook, type});
+        if (it != hooks.end())
+        {
+            it->second.samples.push(duration);
+        }
+    }
+
+    /**
+     * Record how many records the repaint arena allocated and how often its
+     * vectors grew. Allocations of region storage are not included.
+     */
+    void record_arena_allocations(size_t count)
+    {
+        if (active)
+        {
+            arena_allocations.push(count);
+        }
+    }
+
+    /** Record how many GL calls the state tracker issued and elided. */
+    void record_gl_calls()
+    {
+        uint64_t issued, elided;
+        OpenGL::get_state_statistics(issued, elided);
+        if (active)
+        {
+            gl_calls_issued.push(issued);
+            gl_calls_elided.push(elided);
+        }
+    }
+
+    /** Drop the samples of a hook which is being removed. */
+    void forget_hook(const effect_hook_t *hook)
+    {
+        for (int i = 0; i < OUTPUT_EFFECT_TOTAL; i++)
+        {
+            hooks.erase({hook, (output_effect_type_t)i});
+        }
+    }
+
+    /**
+     * The frame has been fully rendered and submitted. Prints a summary
+     * every MAX_SAMPLES frames.
+     */
+    void end_frame()
+    {
+        if (!active)
+        {
+            return;
+        }
+
+        phases[PHASE_FRAME].push(now() - frame_start);
+        active = false;
+
+        if (++rendered_frames % MAX_SAMPLES == 0)
+        {
+            print_summary();
+        }
+    }
+
+    void print_summary() const
+    {
+        static const char *phase_names[PHASE_TOTAL] = {
+            "pre-hooks", "damage-hooks", "render", "overlay",
+            "postprocess", "sw-cursors", "swap", "frame",
+        };
+
+        static const char *hook_types[OUTPUT_EFFECT_TOTAL] = {
+            "pre", "damage", "overlay", "post",
+        };
+
+        LOGC(RENDER, "Frame timings for output ", output->to_string(),
+            " (min/avg/p99 in us, last ", phases[PHASE_FRAME].count, " frames):");
+        for (int i = 0; i < PHASE_TOTAL; i++)
+        {
+            auto s = phases[i].summarize();
+            LOGC(RENDER, "  ", phase_names[i], ": ",
+                s.min / 1000, "/", s.avg / 1000, "/", s.p99 / 1000);
+        }
+
+        auto allocs = arena_allocations.summarize();
+        LOGC(RENDER, "  arena record allocations per frame (min/avg/p99): ",
+            allocs.min, "/", allocs.avg, "/", allocs.p99);
+
+        auto issued = gl_calls_issued.summarize();
+        auto elided = gl_calls_elided.summarize();
+        LOGC(RENDER, "  GL state calls issued per frame (min/avg/p99): ",
+            issued.min, "/", issued.avg, "/", issued.p99);
+        LOGC(RENDER, "  GL state calls elided per frame (min/avg/p99): ",
+            elided.min, "/", elided.avg, "/", elided.p99);
+
+        for (auto& [key, hook] : hooks)
+        {
+            auto s = hook.samples.summarize();
+            LOGC(RENDER, "  ", hook_types[key.second], " hook ", hook.name, ": ",
+                s.min / 1000, "/", s.avg / 1000, "/", s.p99 / 1000);
+        }
+    }
+
+  private:
+    output_t *output;
+    bool active = false;
+    int64_t frame_start = 0;
+    int64_t last_mark   = 0;
+    uint64_t rendered_frames = 0;
+
+    samples_t phases[PHASE_TOTAL];
+    samples_t arena_allocations;
+    samples_t gl_calls_issued;
+    samples_t gl_calls_elided;
+
+    struct hook_samples_t
+    {
+        std::string name;
+        samples_t samples;
+    };
+
+    std::map<std::pair<const effect_hook_t*, output_effect_type_t>,
+        hook_samples_t> hooks;
+};
+
 /**
  * Very simple class to manage effect hooks
  */
 struct effect_hook_manager_t
 {
-    using effect_container_t = wf::safe_list_t<effect_hook_t*>;
+    using effect_container_t = wf::safe_vector_t<effect_hook_t*>;
     effect_container_t effects[OUTPUT_EFFECT_TOTAL];
 
     void add_effect(effect_hook_t *hook, output_effect_type_t type)
@@ -254,10 +555,22 @@ struct effect_hook_manager_t
         }
     }
 
-    void run_effects(output_effect_type_t type)
+    void run_effects(output_effect_type_t type, frame_profiler_t& profiler)
     {
-        effects[type].for_each([] (auto effect)
-        { (*effect)(); });
+        OpenGL::untracked_scope_t plugin_gl;
+        if (!profiler.is_active())
+        {
+            effects[type].for_each([] (auto effect)
+            { (*effect)(); });
+            return;
+        }
+
+        effects[type].for_each([&] (auto effect)
+        {
+            auto start = frame_profiler_t::now();
+            (*effect)();
+            profiler.record_hook(effect, type, frame_profiler_t::now() - start);
+        });
     }
 };
 
@@ -266,7 +579,7 @@ struct effect_hook_manager_t
  */
 struct postprocessing_manager_t
 {
-    using post_container_t = wf::safe_list_t<post_hook_t*>;
+    using post_container_t = wf::safe_vector_t<post_hook_t*>;
     post_container_t post_effects;
     wf::framebuffer_base_t post_buffers[3];
     /* Buffer to which other operations render to */
@@ -277,6 +590,10 @@ struct postprocessing_manager_t
     postprocessing_manager_t(output_t *output)
     {
         this->output = output;
+        for (auto& buffer : post_buffers)
+        {
+            buffer.owner = "output " + output->to_string() + " postprocessing";
+        }
     }
 
     void workaround_wlroots_backend_y_invert(wf::framebuffer_t& fb) const
@@ -355,6 +672,7 @@ struct postprocessing_manager_t
             next_buffer.allocate(output_width, output_height);
             OpenGL::render_end();
 
+            OpenGL::untracked_scope_t plugin_gl;
             (*post)(post_buffers[last_buffer_idx], next_buffer);
 
             last_buffer_idx  = next_buffer_idx;
@@ -411,7 +729,10 @@ class depth_buffer_manager_t
             return;
         }
 
-        attach_buffer(find_buffer(fb), fb, width, height);
+        /* Pooled framebuffers lose their depth buffer when they are
+         * recycled */
+        auto serial = wf::framebuffer_pool_t::get().get_acquire_serial(fb);
+        attach_buffer(find_buffer(fb), fb, serial, width, height);
     }
 
     depth_buffer_manager_t() = default;
@@ -421,7 +742,7 @@ class depth_buffer_manager_t
         OpenGL::render_begin();
         for (auto& buffer : buffers)
         {
-            GL_CALL(glDeleteTextures(1, &buffer.tex));
+            OpenGL::delete_texture(buffer.tex);
         }
 
         OpenGL::render_end();
@@ -439,41 +760,46 @@ class depth_buffer_manager_t
     {
         GLuint tex = -1;
         int attached_to = -1;
+        uint64_t attached_serial = 0;
         int width  = 0;
         int height = 0;
 
         int64_t last_used = 0;
     };
 
-    void attach_buffer(depth_buffer_t& buffer, int fb, int width, int height)
+    void attach_buffer(depth_buffer_t& buffer, int fb, uint64_t serial,
+        int width, int height)
     {
-        if ((buffer.attached_to == fb) &&
-            (buffer.width == width) &&
-            (buffer.height == height))
+        const bool same_size = (buffer.attached_to == fb) &&
+            (buffer.width == width) && (buffer.height == height);
+        if (same_size && (buffer.attached_serial == serial))
         {
             return;
         }
 
-        if (buffer.tex != (GLuint) - 1)
+        if (!same_size)
         {
-            GL_CALL(glDeleteTextures(1, &buffer.tex));
-        }
+            if (buffer.tex != (GLuint) - 1)
+            {
+                OpenGL::delete_texture(buffer.tex);
+            }
 
-        GL_CALL(glGenTextures(1, &buffer.tex));
-        GL_CALL(glBindTexture(GL_TEXTURE_2D, buffer.tex));
-        GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT,
-            width, height, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL));
-        buffer.width  = width;
-        buffer.height = height;
+            GL_CALL(glGenTextures(1, &buffer.tex));
+            OpenGL::bind_texture(GL_TEXTURE_2D, buffer.tex);
+            GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT,
+                width, height, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL));
+            buffer.width  = width;
+            buffer.height = height;
+        }
 
-        GL_CALL(glBindTexture(GL_TEXTURE_2D, buffer.tex));
-        GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, fb));
+        OpenGL::bind_framebuffer(GL_FRAMEBUFFER, fb);
         GL_CALL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
             GL_TEXTURE_2D, buffer.tex, 0));
-        GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
+        OpenGL::bind_texture(GL_TEXTURE_2D, 0);
 
-        buffer.attached_to = fb;
-        buffer.last_used   = get_current_time();
+        buffer.attached_to     = fb;
+        buffer.attached_serial = serial;
+        buffer.last_used = get_current_time();
     }
 
     depth_buffer_t& find_buffer(int fb)
@@ -510,6 +836,79 @@ class depth_buffer_manager_t
     std::vector<depth_buffer_t> buffers;
 };
 
+/**
+ * A histogram of the render durations of the last WINDOW frames.
+ *
+ * Durations are stored in buckets of BUCKET_USEC microseconds, the last bucket
+ * also accumulates all durations which are longer than that. Percentiles are
+ * rounded up to the upper end of the bucket, so they are never optimistic.
+ */
+struct render_time_histogram_t
+{
+    static constexpr int64_t BUCKET_USEC = 100;
+    static constexpr int NUM_BUCKETS     = 500;
+    static constexpr size_t WINDOW = 128;
+
+    void add(int64_t usec)
+    {
+        int bucket = clamp(int(usec / BUCKET_USEC), 0, NUM_BUCKETS - 1);
+        if (count == WINDOW)
+        {
+            --buckets[window[next]];
+        } else
+        {
+            ++count;
+        }
+
+        window[next] = bucket;
+        ++buckets[bucket];
+        next = (next + 1) % WINDOW;
+    }
+
+    void clear()
+    {
+        buckets.fill(0);
+        count = 0;
+        next  = 0;
+    }
+
+    size_t size() const
+    {
+        return count;
+    }
+
+    /**
+     * @return The smallest duration in microseconds which is at least as long
+     *   as @percentile percent of the recorded durations.
+     */
+    int64_t get_percentile(int percentile) const
+    {
+        if (count == 0)
+        {
+            return 0;
+        }
+
+        size_t needed = (count * clamp(percentile, 0, 100) + 99) / 100;
+        size_t seen   = 0;
+        for (int i = 0; i < NUM_BUCKETS; i++)
+        {
+            seen += buckets[i];
+            if ((seen >= needed) && (seen > 0))
+            {
+                return (i + 1) * BUCKET_USEC;
+            }
+        }
+
+        return NUM_BUCKETS * BUCKET_USEC;
+    }
+
+  private:
+    std::array<uint32_t, NUM_BUCKETS> buckets{};
+    std::array<int, WINDOW> window;
+    size_t count = 0;
+    size_t next  = 0;
+};
+
 /**
  * A struct which manages the repaint delay.
  *
@@ -527,7 +926,9 @@ class depth_buffer_manager_t
  * and can change depending on active plugins, number of opened windows, etc.
  *
  * Thus, we need to dynamically guess this time based on the previous frames.
- * Currently, the following algorithm is implemented:
+ * Two algorithms are implemented, selected by `core/repaint_scheduler`.
+ *
+ * The `adaptive` scheduler works as follows:
  *
  * Initially, the repaint delay is zero.
  *
@@ -538,17 +939,43 @@ class depth_buffer_manager_t
  * delay is increased by one. If the next frame is delayed, then
  * `increase_window` is doubled, otherwise, it is halved
  * (but it must stay between `MIN_INCREASE_WINDOW` and `MAX_INCREASE_WINDOW`).
+ *
+ * The `predictive` scheduler instead records how long each presented frame
+ * took to render, and sets the delay so that a frame which takes as long as
+ * `core/repaint_percentile` percent of the recent frames, plus a safety
+ * margin of `core/repaint_safety_margin` milliseconds, still fits in the
+ * refresh cycle. Whenever the rendering workload changes (a plugin installs
+ * a custom renderer or changes the postprocessing chain), the recorded
+ * durations are discarded and the delay drops to zero until enough new
+ * samples are collected. Effect hooks come and go with every animation, so
+ * they do not reset the measurements.
+ *
+ * The state of either scheduler is available to plugins with
+ * render_manager::get_repaint_statistics().
  */
 struct repaint_delay_manager_t
 {
     repaint_delay_manager_t(wf::output_t *output)
     {
+        this->output = output;
         on_present.set_callback([&] (void *data)
         {
             auto ev = static_cast<wlr_output_event_present*>(data);
             this->refresh_nsec = ev->refresh;
+            if (ev->presented && (pending_render_usec >= 0))
+            {
+                render_times.add(pending_render_usec);
+            }
+
+            pending_render_usec = -1;
         });
         on_present.connect(&output->handle->events.present);
+
+        scheduler_mode.set_callback([=] ()
+        {
+            predictive = ((std::string)scheduler_mode == "predictive");
+        });
+        predictive = ((std::string)scheduler_mode == "predictive");
     }
 
     /**
@@ -575,7 +1002,73 @@ struct repaint_delay_manager_t
         const int64_t refresh = this->refresh_nsec / 1e6;
         const int64_t on_time_thresh = refresh * 1.5;
         const int64_t last_frame_len = get_current_time() - last_pageflip;
-        if (last_frame_len <= on_time_thresh)
+        const bool on_time = (last_frame_len <= on_time_thresh);
+        update_statistics(on_time);
+
+        if (predictive)
+        {
+            update_predictive_delay();
+        } else
+        {
+            update_adaptive_delay(on_time);
+        }
+
+        last_pageflip = get_current_time();
+    }
+
+    /**
+     * A frame was rendered and submitted. If it is presented, its duration
+     * will be used for the predictive scheduler.
+     *
+     * @param usec How long rendering the frame took, in microseconds.
+     */
+    void frame_rendered(int64_t usec)
+    {
+        pending_render_usec = usec;
+    }
+
+    /**
+     * The rendering workload has changed significantly, so old render times
+     * are no longer a good prediction.
+     */
+    void workload_changed()
+    {
+        render_times.clear();
+        pending_render_usec = -1;
+        predicted_render_usec = -1;
+        if (predictive)
+        {
+            delay = 0;
+        }
+    }
+
+    /**
+     * @return The delay in milliseconds for the current frame.
+     */
+    int get_delay()
+    {
+        return delay;
+    }
+
+    /**
+     * @return The state of the scheduler, see repaint_statistics_t.
+     */
+    repaint_statistics_t get_statistics() const
+    {
+        repaint_statistics_t stats;
+        stats.scheduler = predictive ? "predictive" : "adaptive";
+        stats.delay     = delay;
+        stats.predicted_render_time = predictive ? predicted_render_usec : -1;
+        stats.miss_rate = miss_rate;
+        return stats;
+    }
+
+  private:
+    int delay = 0;
+
+    void update_adaptive_delay(bool on_time)
+    {
+        if (on_time)
         {
             // We rendered last frame on time
             if (get_current_time() - last_increase >= increase_window)
@@ -611,21 +1104,8 @@ struct repaint_delay_manager_t
 
             reset_increase_timer();
         }
-
-        last_pageflip = get_current_time();
     }
 
-    /**
-     * @return The delay in milliseconds for the current frame.
-     */
-    int get_delay()
-    {
-        return delay;
-    }
-
-  private:
-    int delay = 0;
-
     void update_delay(int delta)
     {
         int config_delay = std::max(0,
@@ -645,6 +1125,40 @@ struct repaint_delay_manager_t
         delay = clamp(delay + delta, min, max);
     }
 
+    void update_predictive_delay()
+    {
+        if (render_times.size() < MIN_PREDICTIVE_SAMPLES)
+        {
+            delay = 0;
+            predicted_render_usec = -1;
+            return;
+        }
+
+        predicted_render_usec = render_times.get_percentile(percentile);
+        const int64_t refresh_usec = this->refresh_nsec / 1000;
+        const int64_t budget_usec  = predicted_render_usec + safety_margin * 1000;
+
+        // Round the delay down, so that it is never too large.
+        delay = std::max(int64_t(0), (refresh_usec - budget_usec) / 1000);
+    }
+
+    void update_statistics(bool on_time)
+    {
+        ++period_frames;
+        period_misses += !on_time;
+        if (period_frames < STATISTICS_PERIOD)
+        {
+            return;
+        }
+
+        miss_rate = 1.0 * period_misses / period_frames;
+        LOGC(RENDER, "Repaint scheduler (", predictive ? "predictive" : "adaptive",
+            ") for output ", output->to_string(), ": delay ", delay, "ms, missed ",
+            period_misses, "/", period_frames, " frames");
+
+        period_frames = period_misses = 0;
+    }
+
     void reset_increase_timer()
     {
         last_increase = get_current_time();
@@ -664,13 +1178,48 @@ struct repaint_delay_manager_t
     // Time of last frame
     int64_t last_pageflip = -1; // -1 is invalid
 
-    int64_t refresh_nsec;
+    // Render durations for the predictive scheduler
+    static constexpr size_t MIN_PREDICTIVE_SAMPLES = 8;
+    render_time_histogram_t render_times;
+    // Render duration of the last submitted frame, -1 if none
+    int64_t pending_render_usec = -1;
+    // Render duration the delay was last chosen for, -1 if none
+    int64_t predicted_render_usec = -1;
+
+    // Miss statistics, common for both schedulers
+    static constexpr int STATISTICS_PERIOD = 256;
+    int period_frames = 0;
+    int period_misses = 0;
+    double miss_rate  = 0.0;
+
+    wf::output_t *output;
+    int64_t refresh_nsec = 0;
     wf::option_wrapper_t<int> max_render_time{"core/max_render_time"};
     wf::option_wrapper_t<bool> dynamic_delay{"workarounds/dynamic_repaint_delay"};
+    wf::option_wrapper_t<std::string> scheduler_mode{"core/repaint_scheduler"};
+    bool predictive = false;
+    wf::option_wrapper_t<int> percentile{"core/repaint_percentile"};
+    wf::option_wrapper_t<int> safety_margin{"core/repaint_safety_margin"};
 
     wf::wl_listener_wrapper on_present;
 };
 
+/**
+ * Serial number for the cached view coverage (see view_priv_impl::coverage).
+ * It is incremented for each workspace stream update and each round of frame
+ * events, because plugins can move views or change their transformers between
+ * stream updates, also outside of the repaint of an output. It is shared
+ * between all outputs, so that a value cached while repainting one output is
+ * never reused by another output's repaint.
+ */
+static uint64_t current_coverage_serial = 0;
+
+/* Emitted for each repaint of each workspace stream */
+static const wf::typed_signal_id_t<wf::stream_signal_t>
+stream_pre_id{"workspace-stream-pre"};
+static const wf::typed_signal_id_t<wf::stream_signal_t>
+stream_post_id{"workspace-stream-post"};
+
 class wf::render_manager::impl
 {
   public:
@@ -684,8 +1233,10 @@ class wf::render_manager::impl
     std::unique_ptr<postprocessing_manager_t> postprocessing;
     std::unique_ptr<depth_buffer_manager_t> depth_buffer_manager;
     std::unique_ptr<repaint_delay_manager_t> delay_manager;
+    std::unique_ptr<frame_profiler_t> profiler;
 
     wf::option_wrapper_t<wf::color_t> background_color_opt;
+    wf::option_wrapper_t<int> occluded_frame_rate{"core/occluded_frame_rate"};
 
     impl(output_t *o) :
         output(o)
@@ -695,6 +1246,7 @@ class wf::render_manager::impl
         postprocessing = std::make_unique<postprocessing_manager_t>(o);
         depth_buffer_manager = std::make_unique<depth_buffer_manager_t>();
         delay_manager = std::make_unique<repaint_delay_manager_t>(o);
+        profiler = std::make_unique<frame_profiler_t>(o);
 
         on_frame.set_callback([&] (void*)
         {
@@ -737,9 +1289,27 @@ class wf::render_manager::impl
     workspace_stream_t default_stream;
 
     render_hook_t renderer;
+    /* Damage reported by the render hook in the current frame */
+    wf::region_t renderer_damage;
+    bool renderer_reported_damage = false;
+    bool in_renderer = false;
+
+    void add_renderer_damage(const wf::region_t& region)
+    {
+        if (!in_renderer)
+        {
+            LOGE("add_renderer_damage() called outside of a render hook!");
+            return;
+        }
+
+        renderer_damage |= region;
+        renderer_reported_damage = true;
+    }
+
     void set_renderer(render_hook_t rh)
     {
         renderer = rh;
+        delay_manager->workload_changed();
         output_damage->damage_whole_idle();
     }
 
@@ -830,16 +1400,24 @@ class wf::render_manager::impl
             return false;
         }
 
-        auto views = output->workspace->get_views_on_workspace(
-            output->workspace->get_current_workspace(), wf::VISIBLE_LAYERS);
+        /* The topmost view on the current workspace */
+        auto ws = output->workspace->get_current_workspace();
+        wayfire_view candidate = nullptr;
+        for (auto& view :
+             output->workspace->get_views_in_layer_span(wf::VISIBLE_LAYERS))
+        {
+            if (output->workspace->view_visible_on(view, ws))
+            {
+                candidate = view;
+                break;
+            }
+        }
 
-        if (views.empty())
+        if (!candidate)
         {
             return false;
         }
 
-        auto candidate = views.front();
-
         // The candidate must cover the whole output
         if (candidate->get_output_geometry() != output->get_relative_geometry())
         {
@@ -909,9 +1487,29 @@ class wf::render_manager::impl
     {
         if (renderer)
         {
-            renderer(postprocessing->get_target_framebuffer());
-            /* TODO: let custom renderers specify what they want to repaint... */
-            swap_damage |= output_damage->get_wlr_damage_box();
+            renderer_damage.clear();
+            renderer_reported_damage = false;
+
+            in_renderer = true;
+            {
+                OpenGL::untracked_scope_t plugin_gl;
+                renderer(postprocessing->get_target_framebuffer());
+            }
+
+            in_renderer = false;
+
+            /* The reported damage is used only for the swap. It is not part of
+             * the output's damage history, so render hooks repaint the whole
+             * buffer regardless of its age. */
+            if (renderer_reported_damage)
+            {
+                swap_damage |= (output_damage->get_scheduled_damage() |
+                    renderer_damage) * output->handle->scale;
+                swap_damage &= output_damage->get_wlr_damage_box();
+            } else
+            {
+                swap_damage |= output_damage->get_wlr_damage_box();
+            }
         } else
         {
             swap_damage =
@@ -940,9 +1538,14 @@ class wf::render_manager::impl
      */
     void paint()
     {
+        const int64_t paint_start = frame_profiler_t::now();
+
         /* Part 1: frame setup: query damage, etc. */
-        effects->run_effects(OUTPUT_EFFECT_PRE);
-        effects->run_effects(OUTPUT_EFFECT_DAMAGE);
+        profiler->start_frame();
+        effects->run_effects(OUTPUT_EFFECT_PRE, *profiler);
+        profiler->mark(frame_profiler_t::PHASE_PRE_HOOKS);
+        effects->run_effects(OUTPUT_EFFECT_DAMAGE, *profiler);
+        profiler->mark(frame_profiler_t::PHASE_DAMAGE_HOOKS);
 
         if (do_direct_scanout())
         {
@@ -982,9 +1585,11 @@ class wf::render_manager::impl
         /* Part 2: call the renderer, which sets swap_damage and
          * draws the scenegraph */
         render_output();
+        profiler->mark(frame_profiler_t::PHASE_RENDER);
 
         /* Part 3: overlay effects */
-        effects->run_effects(OUTPUT_EFFECT_OVERLAY);
+        effects->run_effects(OUTPUT_EFFECT_OVERLAY, *profiler);
+        profiler->mark(frame_profiler_t::PHASE_OVERLAY);
 
         if (postprocessing->post_effects.size())
         {
@@ -1001,22 +1606,37 @@ class wf::render_manager::impl
             OpenGL::render_end();
         }
 
+        profiler->mark(frame_profiler_t::PHASE_POSTPROCESS);
+
         /* Part 5: render sw cursors
          * We render software cursors after everything else
          * for consistency with hardware cursor planes */
         OpenGL::render_begin();
-        wlr_renderer_begin(wf::get_core().renderer,
-            output->handle->width, output->handle->height);
-        wlr_output_render_software_cursors(output->handle,
-            swap_damage.to_pixman());
-        wlr_renderer_end(wf::get_core().renderer);
+        {
+            OpenGL::untracked_scope_t wlroots_gl;
+            wlr_renderer_begin(wf::get_core().renderer,
+                output->handle->width, output->handle->height);
+            wlr_output_render_software_cursors(output->handle,
+                swap_damage.to_pixman());
+            wlr_renderer_end(wf::get_core().renderer);
+        }
+
         OpenGL::render_end();
+        profiler->mark(frame_profiler_t::PHASE_SW_CURSORS);
 
         /* Part 6: finalize frame: swap buffers, send frame_done, etc */
         OpenGL::unbind_output(output);
         output_damage->swap_buffers(swap_damage);
         swap_damage.clear();
+        profiler->mark(frame_profiler_t::PHASE_SWAP);
+        profiler->record_arena_allocations(arena.record_allocations);
+        arena.record_allocations = 0;
+        profiler->record_gl_calls();
+        delay_manager->frame_rendered(
+            (frame_profiler_t::now() - paint_start) / 1000);
         post_paint();
+        wf::snapshot_cache_t::get().frame_done(output);
+        profiler->end_frame();
     }
 
     /**
@@ -1024,7 +1644,7 @@ class wf::render_manager::impl
      */
     void post_paint()
     {
-        effects->run_effects(OUTPUT_EFFECT_POST);
+        effects->run_effects(OUTPUT_EFFECT_POST, *profiler);
 
         if (constant_redraw_counter)
         {
@@ -1033,47 +1653,135 @@ class wf::render_manager::impl
     }
 
     /**
-     * Send frame_done to clients.
+     * Send frame_done to a surface. Occluded surfaces are throttled to
+     * core/occluded_frame_rate frames per second, or don't receive frame
+     * events at all if it is zero.
      */
-    void send_frame_done()
+    void send_surface_frame_done(wf::surface_interface_t *surface,
+        bool occluded, const timespec& repaint_ended)
     {
-        /* TODO: do this only if the view isn't fully occluded by another */
-        std::vector<wayfire_view> visible_views;
-        if (renderer)
+        const uint32_t now = wf::get_current_time();
+        if (occluded)
         {
-            visible_views = output->workspace->get_views_in_layer(
-                wf::VISIBLE_LAYERS);
-        } else
+            if (occluded_frame_rate <= 0)
+            {
+                return;
+            }
+
+            const uint32_t interval = 1000 / occluded_frame_rate;
+            if (now - surface->priv->last_frame_done < interval)
+            {
+                return;
+            }
+        }
+
+        surface->priv->last_frame_done = now;
+        surface->send_frame_done(repaint_ended);
+    }
+
+    /**
+     * Send frame_done to all surfaces of the given view. Surfaces which are
+     * covered by @opaque are considered occluded. Afterwards, the opaque
+     * region of the view is added to @opaque, unless the view is hidden.
+     *
+     * @param opaque The opaque region of all views above the current one, in
+     *   output-local coordinates, or nullptr if occlusion is not tracked.
+     */
+    void send_view_frame_done(wayfire_view view, wf::region_t *opaque,
+        const timespec& repaint_ended)
+    {
+        // Parts outside of the output are not visible on this output
+        const auto& is_occluded = [&] (wf::geometry_t box)
         {
-            visible_views = output->workspace->get_views_on_workspace(
-                output->workspace->get_current_workspace(),
-                wf::MIDDLE_LAYERS);
+            return opaque && ((wf::region_t{box} &
+                output->get_relative_geometry()) ^ *opaque).empty();
+        };
+
+        if (view->has_transformer() || !opaque || !view->is_visible())
+        {
+            const bool occluded = is_occluded(get_cached_bounding_box(view));
+            view->for_each_surface([&] (const wf::surface_iterator_t& child)
+            {
+                send_surface_frame_done(child.surface, occluded, repaint_ended);
+            });
 
-            // send to all panels/backgrounds/etc
-            auto additional_views = output->workspace->get_views_in_layer(
-                wf::BELOW_LAYERS | wf::ABOVE_LAYERS);
+            // Hidden views are not rendered, so they do not occlude anything
+            if (opaque && view->is_visible())
+            {
+                *opaque |= get_cached_opaque_region(view);
+            }
 
-            visible_views.insert(visible_views.end(),
-                additional_views.begin(), additional_views.end());
+            return;
         }
 
+        auto origin = wf::origin(view->get_output_geometry());
+        view->for_each_surface([&] (const wf::surface_iterator_t& child)
+        {
+            auto size = child.surface->get_size();
+            wf::geometry_t box = {child.position.x, child.position.y,
+                size.width, size.height};
+            send_surface_frame_done(child.surface, is_occluded(box),
+                repaint_ended);
+            *opaque |= child.surface->get_opaque_region(child.position);
+        }, origin);
+    }
+
+    /**
+     * Send frame_done to clients.
+     *
+     * When the default renderer is active, views are visited from top to
+     * bottom, accumulating the opaque regions of the views above them, so
+     * that fully occluded surfaces can be throttled.
+     */
+    void send_frame_done()
+    {
+        ++current_coverage_serial;
+
         timespec repaint_ended;
         clockid_t presentation_clock =
             wlr_backend_get_presentation_clock(wf::get_core_impl().backend);
         clock_gettime(presentation_clock, &repaint_ended);
-        for (auto& v : visible_views)
+
+        const auto& send_to_view = [&] (wayfire_view v, wf::region_t *opaque)
         {
-            for (auto& view : v->enumerate_views())
+            v->for_each_view([&] (wayfire_view view)
             {
-                if (!view->is_mapped())
-                {
-                    continue;
-                }
+                send_view_frame_done(view, opaque, repaint_ended);
+            });
+        };
 
-                for (auto& child : view->enumerate_surfaces())
-                {
-                    child.surface->send_frame_done(repaint_ended);
-                }
+        auto views =
+            output->workspace->get_views_in_layer_span(wf::VISIBLE_LAYERS);
+        if (renderer)
+        {
+            // Custom renderers may show any part of any workspace
+            for (auto& view : views)
+            {
+                send_to_view(view, nullptr);
+            }
+
+            return;
+        }
+
+        auto ws = output->workspace->get_current_workspace();
+        wf::region_t opaque;
+        for (auto& view : views)
+        {
+            if (output->workspace->view_visible_on(view, ws))
+            {
+                send_to_view(view, &opaque);
+            }
+        }
+
+        // send to all panels/backgrounds/etc, even if they are not on the
+        // current workspace
+        for (auto& view : views)
+        {
+            auto layer = output->workspace->get_view_layer(view);
+            if ((layer & (wf::BELOW_LAYERS | wf::ABOVE_LAYERS)) &&
+                !output->workspace->view_visible_on(view, ws))
+            {
+                send_to_view(view, nullptr);
             }
         }
     }
@@ -1082,12 +1790,43 @@ class wf::render_manager::impl
     void workspace_stream_start(workspace_stream_t& stream)
     {
         stream.running = true;
-        stream.scale_x = stream.scale_y = 1;
 
         /* damage the whole workspace region, so that we get a full repaint
          * when updating the workspace */
         output_damage->damage(output_damage->get_ws_box(stream.ws));
-        workspace_stream_update(stream, 1, 1);
+        workspace_stream_update(stream, stream.scale_x, stream.scale_y);
+    }
+
+    /**
+     * @return The transformed bounding box of the view, cached for the
+     *   current repaint.
+     */
+    wf::geometry_t get_cached_bounding_box(wayfire_view view)
+    {
+        auto& coverage = view->view_impl->coverage;
+        if (coverage.bbox_serial != current_coverage_serial)
+        {
+            coverage.bbox = view->get_bounding_box();
+            coverage.bbox_serial = current_coverage_serial;
+        }
+
+        return coverage.bbox;
+    }
+
+    /**
+     * @return The transformed opaque region of the view, cached for the
+     *   current repaint.
+     */
+    const wf::region_t& get_cached_opaque_region(wayfire_view view)
+    {
+        auto& coverage = view->view_impl->coverage;
+        if (coverage.opaque_serial != current_coverage_serial)
+        {
+            coverage.opaque = view->get_transformed_opaque_region();
+            coverage.opaque_serial = current_coverage_serial;
+        }
+
+        return coverage.opaque;
     }
 
     /**
@@ -1105,22 +1844,113 @@ class wf::render_manager::impl
         wf::region_t damage;
     };
 
-    using damaged_surface = std::unique_ptr<damaged_surface_t>;
-
     /**
      * Represents the state while calculating what parts of the output
      * to repaint
      */
     struct workspace_stream_repaint_t
     {
-        std::vector<damaged_surface> to_render;
+        std::vector<damaged_surface_t*> to_render;
         wf::region_t ws_damage;
         wf::framebuffer_t fb;
 
         int ws_dx;
         int ws_dy;
+
+        /* Number of surface records in use before this repaint started */
+        size_t surfaces_mark = 0;
+    };
+
+    /**
+     * The repaint arena keeps the damaged_surface_t and
+     * workspace_stream_repaint_t records, including their region storage,
+     * between frames, so that repainting in a steady state does not need to
+     * allocate new records.
+     *
+     * The arena counts how often its own records and vectors grow. This does
+     * not cover pixman: a reused region still reallocates its storage when it
+     * needs more rectangles than before, and temporary regions used elsewhere
+     * in the repaint are allocated as usual.
+     *
+     * Workspace streams may be updated from within another stream's repaint,
+     * so the records are handed out like a stack.
+     */
+    struct repaint_arena_t
+    {
+        std::vector<std::unique_ptr<damaged_surface_t>> surfaces;
+        size_t used_surfaces = 0;
+
+        std::vector<std::unique_ptr<workspace_stream_repaint_t>> repaints;
+        size_t used_repaints = 0;
+
+        /** Number of record allocations and vector growths by the arena since
+         * the last reset. Region storage is not included. */
+        size_t record_allocations = 0;
+
+        /** Get a cleared repaint record for a new workspace stream repaint. */
+        workspace_stream_repaint_t& push_repaint()
+        {
+            if (used_repaints == repaints.size())
+            {
+                record_allocations += 1 + (repaints.size() == repaints.capacity());
+                repaints.push_back(std::make_unique<workspace_stream_repaint_t>());
+            }
+
+            auto& repaint = *repaints[used_repaints++];
+            /* The alias is cleared in pop_repaint(), so that assigning the
+             * next framebuffer never releases a buffer of the stream, the
+             * output or the framebuffer pool. */
+            assert((repaint.fb.fb == (GLuint)-1) && (repaint.fb.tex == (GLuint)-1));
+            repaint.to_render.clear();
+            repaint.ws_damage.clear();
+            repaint.surfaces_mark = used_surfaces;
+            return repaint;
+        }
+
+        /** Release the last repaint record and all surfaces used by it. */
+        void pop_repaint()
+        {
+            auto& repaint = *repaints[--used_repaints];
+            /* The framebuffer only aliases buffers owned by the stream or the
+             * output. Drop the alias without freeing them, so that the record
+             * never holds a buffer which may be returned to the pool. */
+            repaint.fb.reset();
+            used_surfaces = repaint.surfaces_mark;
+        }
+
+        /** Get a new surface record. Its damage region must be overwritten. */
+        damaged_surface_t *push_surface()
+        {
+            if (used_surfaces == surfaces.size())
+            {
+                record_allocations += 1 + (surfaces.size() == surfaces.capacity());
+                surfaces.push_back(std::make_unique<damaged_surface_t>());
+            }
+
+            auto ds = surfaces[used_surfaces++].get();
+            ds->surface = nullptr;
+            ds->view    = nullptr;
+            ds->pos     = {0, 0};
+            return ds;
+        }
+
+        /** Release the last surface record, if it turned out to be unneeded. */
+        void pop_surface()
+        {
+            --used_surfaces;
+        }
+
+        /** Add a surface record to the render list of the given repaint. */
+        void schedule(workspace_stream_repaint_t& repaint, damaged_surface_t *ds)
+        {
+            record_allocations +=
+                (repaint.to_render.size() == repaint.to_render.capacity());
+            repaint.to_render.push_back(ds);
+        }
     };
 
+    repaint_arena_t arena;
+
     /**
      * Calculate the damaged region of a view which renders with its snapshot
      * and add it to the render list
@@ -1130,17 +1960,22 @@ class wf::render_manager::impl
     void schedule_snapshotted_view(workspace_stream_repaint_t& repaint,
         wayfire_view view, wf::point_t view_delta)
     {
-        auto ds = damaged_surface(new damaged_surface_t);
+        auto ds = arena.push_surface();
 
-        auto bbox = view->get_bounding_box() + view_delta;
-        ds->damage = (repaint.ws_damage & bbox) + -view_delta;
+        auto bbox = get_cached_bounding_box(view) + view_delta;
+        pixman_region32_intersect_rect(ds->damage.to_pixman(),
+            repaint.ws_damage.to_pixman(), bbox.x, bbox.y, bbox.width, bbox.height);
         if (!ds->damage.empty())
         {
+            ds->damage += -view_delta;
+
             ds->pos  = -view_delta;
             ds->view = view.get();
-            repaint.ws_damage ^=
-                view->get_transformed_opaque_region() + view_delta;
-            repaint.to_render.push_back(std::move(ds));
+            repaint.ws_damage ^= get_cached_opaque_region(view) + view_delta;
+            arena.schedule(repaint, ds);
+        } else
+        {
+            arena.pop_surface();
         }
     }
 
@@ -1161,7 +1996,7 @@ class wf::render_manager::impl
             return;
         }
 
-        auto ds = damaged_surface(new damaged_surface_t);
+        auto ds = arena.push_surface();
         wlr_box obox = {
             .x     = pos.x,
             .y     = pos.y,
@@ -1169,7 +2004,8 @@ class wf::render_manager::impl
             .height = surface->get_size().height
         };
 
-        ds->damage = repaint.ws_damage & obox;
+        pixman_region32_intersect_rect(ds->damage.to_pixman(),
+            repaint.ws_damage.to_pixman(), obox.x, obox.y, obox.width, obox.height);
         if (!ds->damage.empty())
         {
             ds->pos     = pos;
@@ -1178,7 +2014,10 @@ class wf::render_manager::impl
             /* Subtract opaque region from workspace damage. The views below
              * won't be visible, so no need to damage them */
             repaint.ws_damage ^= ds->surface->get_opaque_region(pos);
-            repaint.to_render.push_back(std::move(ds));
+            arena.schedule(repaint, ds);
+        } else
+        {
+            arena.pop_surface();
         }
     }
 
@@ -1197,10 +2036,11 @@ class wf::render_manager::impl
             wf::point_t current_output = wf::origin(output->get_layout_geometry());
             auto origin = wf::origin(xw_dnd_icon->get_output_geometry()) +
                 dnd_output + -current_output;
-            for (auto& child : xw_dnd_icon->enumerate_surfaces(origin))
+            xw_dnd_icon->for_each_surface(
+                [&] (const wf::surface_iterator_t& child)
             {
                 schedule_surface(repaint, child.surface, child.position);
-            }
+            }, origin);
         }
 
         auto& drag_icon = wf::get_core_impl().seat->drag_icon;
@@ -1216,10 +2056,10 @@ class wf::render_manager::impl
         offset.x -= og.x;
         offset.y -= og.y;
 
-        for (auto& child : drag_icon->enumerate_surfaces(offset))
+        drag_icon->for_each_surface([&] (const wf::surface_iterator_t& child)
         {
             schedule_surface(repaint, child.surface, child.position);
-        }
+        }, offset);
     }
 
     /**
@@ -1234,25 +2074,57 @@ class wf::render_manager::impl
         }
     }
 
+    /**
+     * Check whether the given box (in workspace coordinates) intersects the
+     * remaining workspace damage. The extents are checked first, so that most
+     * views outside of the damage are rejected without any region operations.
+     */
+    static bool intersects_damage(const workspace_stream_repaint_t& repaint,
+        wf::geometry_t box)
+    {
+        auto extents = wlr_box_from_pixman_box(repaint.ws_damage.get_extents());
+        if (!(extents & box))
+        {
+            return false;
+        }
+
+        return !(repaint.ws_damage & box).empty();
+    }
+
     /**
      * Iterate all visible surfaces on the workspace, and check whether
      * they need repaint.
+     *
+     * Views whose bounding box does not intersect the remaining damage (for
+     * ex. because they are hidden below an opaque fullscreen view) are skipped
+     * without enumerating their surfaces.
      */
     void check_schedule_surfaces(workspace_stream_repaint_t& repaint,
         workspace_stream_t& stream)
     {
-        auto views = output->workspace->get_views_on_workspace(stream.ws,
-            wf::VISIBLE_LAYERS);
+        auto views =
+            output->workspace->get_views_in_layer_span(wf::VISIBLE_LAYERS);
 
         schedule_drag_icon(repaint);
         for (auto& v : views)
         {
-            for (auto& view : v->enumerate_views(false))
+            if (repaint.ws_damage.empty())
+            {
+                // Everything below is hidden or not damaged
+                return;
+            }
+
+            if (!output->workspace->view_visible_on(v, stream.ws))
+            {
+                continue;
+            }
+
+            v->for_each_view([&] (wayfire_view view)
             {
                 wf::point_t view_delta{0, 0};
                 if (!view->is_visible() || repaint.ws_damage.empty())
                 {
-                    continue;
+                    return;
                 }
 
                 if (view->sticky)
@@ -1260,6 +2132,12 @@ class wf::render_manager::impl
                     view_delta = {repaint.ws_dx, repaint.ws_dy};
                 }
 
+                if (!intersects_damage(repaint,
+                    get_cached_bounding_box(view) + view_delta))
+                {
+                    return;
+                }
+
                 /* We use the snapshot of a view on either of the following
                  * conditions:
                  *
@@ -1277,41 +2155,93 @@ class wf::render_manager::impl
                     /* Make sure view position is relative to the workspace
                      * being rendered */
                     auto obox = view->get_output_geometry() + view_delta;
-                    for (auto& child : view->enumerate_surfaces({obox.x, obox.y}))
+                    view->for_each_surface(
+                        [&] (const wf::surface_iterator_t& child)
                     {
                         schedule_surface(repaint, child.surface, child.position);
-                    }
+                    }, {obox.x, obox.y});
                 }
-            }
+            }, false);
         }
     }
 
+    /** The smallest scale at which a workspace stream can be rendered. */
+    static constexpr float MIN_STREAM_SCALE = 0.05;
+
+    /**
+     * Expand the damage of a scaled stream so that it covers whole pixels of
+     * the stream buffer. Otherwise, pixels which are only partially damaged
+     * are cleared, but views which touch only their undamaged part are not
+     * repainted.
+     */
+    void align_damage_to_buffer(wf::region_t& damage, wf::geometry_t ws_box,
+        double scale)
+    {
+        wf::point_t origin = {ws_box.x, ws_box.y};
+        wf::region_t aligned;
+        for (const auto& rect : damage)
+        {
+            int px1 = std::floor((rect.x1 - origin.x) * scale);
+            int py1 = std::floor((rect.y1 - origin.y) * scale);
+            int px2 = std::ceil((rect.x2 - origin.x) * scale);
+            int py2 = std::ceil((rect.y2 - origin.y) * scale);
+
+            int x1 = origin.x + std::floor(px1 / scale);
+            int y1 = origin.y + std::floor(py1 / scale);
+            int x2 = origin.x + std::ceil(px2 / scale);
+            int y2 = origin.y + std::ceil(py2 / scale);
+            aligned |= wf::geometry_t{x1, y1, x2 - x1, y2 - y1};
+        }
+
+        damage = aligned & ws_box;
+    }
+
     /**
      * Setup the stream, calculate damaged region, etc.
      */
-    workspace_stream_repaint_t calculate_repaint_for_stream(
+    void calculate_repaint_for_stream(workspace_stream_repaint_t& repaint,
         workspace_stream_t& stream, float scale_x, float scale_y)
     {
-        workspace_stream_repaint_t repaint;
-        repaint.ws_damage = output_damage->get_ws_damage(stream.ws);
+        output_damage->get_ws_damage(stream.ws, repaint.ws_damage);
+
+        /* The default stream renders directly to the output, so it cannot be
+         * scaled. wf::framebuffer_t supports only uniform scaling, so use the
+         * larger factor for both directions, to avoid losing detail. */
+        float scale = 1.0;
+        if (stream.buffer.tex != 0)
+        {
+            scale = std::clamp(std::max(scale_x, scale_y), MIN_STREAM_SCALE, 1.0f);
+        }
+
+        if ((scale != stream.scale_x) || (scale != stream.scale_y))
+        {
+            /* The buffer is reallocated, so its old contents are lost */
+            stream.scale_x = stream.scale_y = scale;
+            repaint.ws_damage |= output_damage->get_ws_box(stream.ws);
+        }
 
         /* we don't have to update anything */
         if (repaint.ws_damage.empty())
         {
-            return repaint;
+            return;
         }
 
-        if ((scale_x != stream.scale_x) || (scale_y != stream.scale_y))
+        int width  = output->handle->width;
+        int height = output->handle->height;
+        if (scale != 1.0)
         {
-            /* FIXME: enable scaled rendering */
-            // stream->scale_x = scale_x;
-            // stream->scale_y = scale_y;
+            width  = std::max(1, (int)std::ceil(width * scale));
+            height = std::max(1, (int)std::ceil(height * scale));
+        }
 
-            // ws_damage |= get_damage_box();
+        if (stream.buffer.owner.empty())
+        {
+            stream.buffer.owner = "output " + output->to_string() +
+                " workspace stream";
         }
 
         OpenGL::render_begin();
-        stream.buffer.allocate(output->handle->width, output->handle->height);
+        stream.buffer.allocate(width, height);
         OpenGL::render_end();
 
         repaint.fb = postprocessing->get_target_framebuffer();
@@ -1320,6 +2250,9 @@ class wf::render_manager::impl
             /* Use the workspace buffers */
             repaint.fb.fb  = stream.buffer.fb;
             repaint.fb.tex = stream.buffer.tex;
+            repaint.fb.viewport_width  = stream.buffer.viewport_width;
+            repaint.fb.viewport_height = stream.buffer.viewport_height;
+            repaint.fb.scale *= scale;
         }
 
         auto g   = output->get_relative_geometry();
@@ -1330,7 +2263,11 @@ class wf::render_manager::impl
         repaint.fb.geometry.x = repaint.ws_dx;
         repaint.fb.geometry.y = repaint.ws_dy;
 
-        return repaint;
+        if (scale != 1.0)
+        {
+            align_damage_to_buffer(repaint.ws_damage,
+                output_damage->get_ws_box(stream.ws), repaint.fb.scale);
+        }
     }
 
     void clear_empty_areas(workspace_stream_repaint_t& repaint, wf::color_t color)
@@ -1365,14 +2302,15 @@ class wf::render_manager::impl
             {
                 repaint.fb.geometry = fb_geometry + ds->pos;
                 ds->view->render_transformed(repaint.fb, ds->damage);
-                for (auto& child : ds->view->enumerate_surfaces({0, 0}))
+                ds->view->for_each_surface(
+                    [&] (const wf::surface_iterator_t& child)
                 {
                     send_sampled_on_output(child.surface);
-                }
+                });
             } else
             {
                 repaint.fb.geometry = fb_geometry;
-                ds->surface->simple_render(repaint.fb,
+                wf::render_surface(ds->surface, repaint.fb,
                     ds->pos.x, ds->pos.y, ds->damage);
                 send_sampled_on_output(ds->surface);
             }
@@ -1385,17 +2323,23 @@ class wf::render_manager::impl
     void workspace_stream_update(workspace_stream_t& stream,
         float scale_x = 1, float scale_y = 1)
     {
-        workspace_stream_repaint_t repaint =
-            calculate_repaint_for_stream(stream, scale_x, scale_y);
+        /* Plugins update streams from their hooks, where the GL state is not
+         * tracked, but the stream itself is rendered by the core. */
+        OpenGL::tracked_scope_t core_gl;
+        ++current_coverage_serial;
+        auto& repaint = arena.push_repaint();
+        calculate_repaint_for_stream(repaint, stream, scale_x, scale_y);
 
         if (repaint.ws_damage.empty())
         {
+            arena.pop_repaint();
             return;
         }
 
         {
+            OpenGL::untracked_scope_t plugin_gl;
             stream_signal_t data(stream.ws, repaint.ws_damage, repaint.fb);
-            output->render->emit_signal("workspace-stream-pre", &data);
+            output->render->emit_signal(stream_pre_id, &data);
         }
 
         check_schedule_surfaces(repaint, stream);
@@ -1412,9 +2356,12 @@ class wf::render_manager::impl
 
         unschedule_drag_icon();
         {
+            OpenGL::untracked_scope_t plugin_gl;
             stream_signal_t data(stream.ws, repaint.ws_damage, repaint.fb);
-            output->render->emit_signal("workspace-stream-post", &data);
+            output->render->emit_signal(stream_post_id, &data);
         }
+
+        arena.pop_repaint();
     }
 
     void workspace_stream_stop(workspace_stream_t& stream)
@@ -1432,6 +2379,11 @@ void render_manager::set_renderer(render_hook_t rh)
     pimpl->set_renderer(rh);
 }
 
+void render_manager::add_renderer_damage(const wf::region_t& region)
+{
+    pimpl->add_renderer_damage(region);
+}
+
 void render_manager::set_redraw_always(bool always)
 {
     pimpl->set_redraw_always(always);
@@ -1452,24 +2404,29 @@ void render_manager::add_inhibit(bool add)
     pimpl->add_inhibit(add);
 }
 
-void render_manager::add_effect(effect_hook_t *hook, output_effect_type_t type)
+void render_manager::add_effect(effect_hook_t *hook, output_effect_type_t type,
+    const std::string& name)
 {
     pimpl->effects->add_effect(hook, type);
+    pimpl->profiler->register_hook(hook, type, name);
 }
 
 void render_manager::rem_effect(effect_hook_t *hook)
 {
     pimpl->effects->rem_effect(hook);
+    pimpl->profiler->forget_hook(hook);
 }
 
 void render_manager::add_post(post_hook_t *hook)
 {
     pimpl->postprocessing->add_post(hook);
+    pimpl->delay_manager->workload_changed();
 }
 
 void render_manager::rem_post(post_hook_t *hook)
 {
     pimpl->postprocessing->rem_post(hook);
+    pimpl->delay_manager->workload_changed();
 }
 
 wf::region_t render_manager::get_scheduled_damage()
@@ -1497,6 +2454,11 @@ void render_manager::damage(const wf::region_t& region)
     pimpl->output_damage->damage(region);
 }
 
+wf::repaint_statistics_t render_manager::get_repaint_statistics() const
+{
+    return pimpl->delay_manager->get_statistics();
+}
+
 wlr_box render_manager::get_ws_box(wf::point_t ws) const
 {
     return pimpl->output_damage->get_ws_box(ws);
@@ -1515,7 +2477,7 @@ void render_manager::workspace_stream_start(workspace_stream_t& stream)
 void render_manager::workspace_stream_update(workspace_stream_t& stream,
     float scale_x, float scale_y)
 {
-    pimpl->workspace_stream_update(stream);
+    pimpl->workspace_stream_update(stream, scale_x, scale_y);
 }
 
 void render_manager::workspace_stream_stop(workspace_stream_t& stream)
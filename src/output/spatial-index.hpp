@@ -0,0 +1,382 @@
+#ifndef WF_SPATIAL_INDEX_HPP
+#define WF_SPATIAL_INDEX_HPP
+
+#include <wayfire/geometry.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace wf
+{
+/**
+ * A uniform grid which finds the boxes intersecting a given area without
+ * looking at all boxes.
+ *
+ * Each box is stored in every cell of the grid it overlaps, and a query only
+ * visits the cells overlapped by the queried area. Boxes which overlap too
+ * many cells are kept in a separate list which every query visits, so that
+ * a few huge boxes do not fill the whole grid.
+ *
+ * Boxes can have any coordinates, including negative ones.
+ */
+template<class Key>
+class spatial_index_t
+{
+  public:
+    /** The maximal number of cells a box is stored in */
+    static constexpr int MAX_CELLS_PER_BOX = 64;
+
+    spatial_index_t(wf::dimensions_t cell_size = {1024, 1024})
+    {
+        set_cell_size(cell_size);
+    }
+
+    spatial_index_t(const spatial_index_t&) = delete;
+    spatial_index_t& operator =(const spatial_index_t&) = delete;
+
+    /** Change the size of the cells, and redistribute the boxes */
+    void set_cell_size(wf::dimensions_t size)
+    {
+        size.width  = std::max(size.width, 1);
+        size.height = std::max(size.height, 1);
+        if (size == cell_size)
+        {
+            return;
+        }
+
+        cell_size = size;
+        cells.clear();
+        oversized.clear();
+        for (auto& [key, entry] : entries)
+        {
+            entry.range = get_range(entry.box);
+            link(&entry);
+        }
+    }
+
+    wf::dimensions_t get_cell_size() const
+    {
+        return cell_size;
+    }
+
+    /** Add the key with the given box, or move the box of an existing key */
+    void update(Key key, wf::geometry_t box)
+    {
+        auto [it, inserted] = entries.try_emplace(key);
+        auto& entry = it->second;
+        entry.key = key;
+
+        auto range = get_range(box);
+        if (!inserted && (range == entry.range))
+        {
+            entry.box = box;
+            return;
+        }
+
+        if (!inserted)
+        {
+            unlink(&entry);
+        }
+
+        entry.box   = box;
+        entry.range = range;
+        link(&entry);
+    }
+
+    /** Remove the key from the index. No-op if it is not in the index. */
+    void remove(Key key)
+    {
+        auto it = entries.find(key);
+        if (it != entries.end())
+        {
+            unlink(&it->second);
+            entries.erase(it);
+        }
+    }
+
+    /** Remove all keys from the index */
+    void clear()
+    {
+        cells.clear();
+        oversized.clear();
+        entries.clear();
+    }
+
+    bool contains(Key key) const
+    {
+        return entries.count(key);
+    }
+
+    size_t size() const
+    {
+        return entries.size();
+    }
+
+    /**
+     * Call func(key) once for each key whose box has a common point with the
+     * area, as defined by operator &. The order of the keys is unspecified.
+     *
+     * func must not modify the index.
+     */
+    template<class Func>
+    void for_each_intersecting(wf::geometry_t area, Func func)
+    {
+        ++query_serial;
+        auto visit = [&] (entry_t *entry)
+        {
+            if ((entry->last_query != query_serial) && (entry->box & area))
+            {
+                entry->last_query = query_serial;
+                func(entry->key);
+            }
+        };
+
+        for (auto& entry : oversized)
+        {
+            visit(entry);
+        }
+
+        auto range = get_range(area);
+        if (range.cell_count() > (int64_t)cells.size())
+        {
+            /* Cheaper to look at all occupied cells than at all queried ones */
+            for (auto& [cell, cell_entries] : cells)
+            {
+                for (auto& entry : cell_entries)
+                {
+                    visit(entry);
+                }
+            }
+
+            return;
+        }
+
+        for (int x = range.x1; x <= range.x2; x++)
+        {
+            for (int y = range.y1; y <= range.y2; y++)
+            {
+                auto it = cells.find(get_cell_id(x, y));
+                if (it == cells.end())
+                {
+                    continue;
+                }
+
+                for (auto& entry : it->second)
+                {
+                    visit(entry);
+                }
+            }
+        }
+    }
+
+  private:
+    /** An inclusive range of cells */
+    struct cell_range_t
+    {
+        int x1, y1, x2, y2;
+
+        int64_t cell_count() const
+        {
+            return int64_t(x2 - x1 + 1) * (y2 - y1 + 1);
+        }
+
+        bool operator ==(const cell_range_t& other) const
+        {
+            return x1 == other.x1 && y1 == other.y1 &&
+                   x2 == other.x2 && y2 == other.y2;
+        }
+    };
+
+    struct entry_t
+    {
+        Key key;
+        wf::geometry_t box;
+        cell_range_t range;
+        /* The last query which visited the entry */
+        uint64_t last_query = 0;
+    };
+
+    wf::dimensions_t cell_size = {0, 0};
+    uint64_t query_serial = 0;
+
+    /* Nodes of unordered_map are never moved, so cells can point to them */
+    std::unordered_map<Key, entry_t> entries;
+    std::unordered_map<uint64_t, std::vector<entry_t*>> cells;
+    std::vector<entry_t*> oversized;
+
+    static uint64_t get_cell_id(int x, int y)
+    {
+        return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+    }
+
+    static int floor_div(int64_t a, int b)
+    {
+        return (int)(a >= 0 ? a / b : -((-a + b - 1) / b));
+    }
+
+    cell_range_t get_range(wf::geometry_t box) const
+    {
+        /* Empty boxes still have a common point with the boxes around them */
+        int64_t width  = std::max(box.width, 1);
+        int64_t height = std::max(box.height, 1);
+
+        cell_range_t range;
+        range.x1 = floor_div(box.x, cell_size.width);
+        range.y1 = floor_div(box.y, cell_size.height);
+        range.x2 = floor_div(box.x + width - 1, cell_size.width);
+        range.y2 = floor_div(box.y + height - 1, cell_size.height);
+        return range;
+    }
+
+    void link(entry_t *entry)
+    {
+        if (entry->range.cell_count() > MAX_CELLS_PER_BOX)
+        {
+            oversized.push_back(entry);
+            return;
+        }
+
+        for (int x = entry->range.x1; x <= entry->range.x2; x++)
+        {
+            for (int y = entry->range.y1; y <= entry->range.y2; y++)
+            {
+                cells[get_cell_id(x, y)].push_back(entry);
+            }
+        }
+    }
+
+    void unlink(entry_t *entry)
+    {
+        auto erase_from = [&] (std::vector<entry_t*>& list)
+        {
+            auto it = std::find(list.begin(), list.end(), entry);
+            if (it != list.end())
+            {
+                /* The order within a cell does not matter */
+                std::swap(*it, list.back());
+                list.pop_back();
+            }
+        };
+
+        if (entry->range.cell_count() > MAX_CELLS_PER_BOX)
+        {
+            erase_from(oversized);
+            return;
+        }
+
+        for (int x = entry->range.x1; x <= entry->range.x2; x++)
+        {
+            for (int y = entry->range.y1; y <= entry->range.y2; y++)
+            {
+                auto it = cells.find(get_cell_id(x, y));
+                erase_from(it->second);
+                if (it->second.empty())
+                {
+                    cells.erase(it);
+                }
+            }
+        }
+    }
+};
+
+/**
+ * Indexes boxes which are given relative to the current workspace of an
+ * output, for example the wm geometry of views, by their position in the
+ * whole workspace grid.
+ *
+ * When the current workspace changes, boxes which are not updated keep their
+ * relative position, i.e they follow the current workspace, like the views
+ * which are not moved by a workspace switch.
+ */
+template<class Key>
+class workspace_index_t
+{
+  public:
+    workspace_index_t(wf::dimensions_t screen_size = {1920, 1080}) :
+        index(screen_size), screen_size(screen_size)
+    {}
+
+    /** Change the size of a workspace, which is also the size of the cells */
+    void set_screen_size(wf::dimensions_t size)
+    {
+        if (size == screen_size)
+        {
+            return;
+        }
+
+        screen_size = size;
+        index.set_cell_size(size);
+        reindex();
+    }
+
+    wf::dimensions_t get_screen_size() const
+    {
+        return screen_size;
+    }
+
+    /** Change the current workspace, keeping all boxes relative to it */
+    void set_current_workspace(wf::point_t ws)
+    {
+        if (ws == current)
+        {
+            return;
+        }
+
+        current = ws;
+        reindex();
+    }
+
+    /** Add the key with the given box, or move the box of an existing key */
+    void update(Key key, wf::geometry_t box)
+    {
+        boxes[key] = box;
+        index.update(key, to_absolute(box));
+    }
+
+    /** Remove the key from the index. No-op if it is not in the index. */
+    void remove(Key key)
+    {
+        boxes.erase(key);
+        index.remove(key);
+    }
+
+    bool contains(Key key) const
+    {
+        return boxes.count(key);
+    }
+
+    /**
+     * Call func(key) once for each key whose box has a common point with the
+     * area, which is relative to the current workspace.
+     */
+    template<class Func>
+    void for_each_intersecting(wf::geometry_t area, Func func)
+    {
+        index.for_each_intersecting(to_absolute(area), func);
+    }
+
+  private:
+    spatial_index_t<Key> index;
+    /* The boxes relative to the current workspace */
+    std::unordered_map<Key, wf::geometry_t> boxes;
+    wf::dimensions_t screen_size;
+    wf::point_t current = {0, 0};
+
+    wf::geometry_t to_absolute(wf::geometry_t box) const
+    {
+        return box + wf::point_t{current.x * screen_size.width,
+            current.y * screen_size.height};
+    }
+
+    void reindex()
+    {
+        for (auto& [key, box] : boxes)
+        {
+            index.update(key, to_absolute(box));
+        }
+    }
+};
+}
+
+#endif /* end of include guard: WF_SPATIAL_INDEX_HPP */
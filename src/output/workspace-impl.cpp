@@ -7,449 +7,18 @@
 #include <wayfire/opengl.hpp>
 #include <list>
 #include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
 #include <wayfire/nonstd/reverse.hpp>
 #include <wayfire/util/log.hpp>
 
 #include "../view/view-impl.hpp"
 #include "output-impl.hpp"
+#include "layer-manager.hpp"
+#include "spatial-index.hpp"
 
 namespace wf
 {
-/** Find a smart pointer inside a list */
-template<class Haystack, class Needle>
-typename std::list<Haystack>::iterator find_in(std::list<Haystack>& hay,
-    const Needle& needle)
-{
-    return std::find_if(std::begin(hay), std::end(hay), [=] (const auto& elem)
-    {
-        return elem.get() == needle.get();
-    });
-}
-
-/** Bring to front or lower to back inside a container of smart pointers */
-template<class Haystack, class Needle>
-void raise_to_front(std::list<Haystack>& hay, const Needle& needle,
-    bool reverse = false)
-{
-    auto it = find_in(hay, needle);
-    hay.splice(reverse ? hay.end() : hay.begin(), hay, it);
-}
-
-/** Reorder list so that @element is directly above @below. */
-template<class Haystack, class Needle>
-void reorder_above(
-    std::list<Haystack>& list, const Needle& element, const Needle& below)
-{
-    auto element_it = find_in(list, element);
-    auto pos = find_in(list, below);
-    list.splice(pos, list, element_it);
-}
-
-/** Reorder list so that @element is directly below @above. */
-template<class Haystack, class Needle>
-void reorder_below(
-    std::list<Haystack>& list, const Needle& element, const Needle& above)
-{
-    auto element_it = find_in(list, element);
-    auto pos = find_in(list, above);
-    assert(pos != list.end());
-    list.splice(std::next(pos), list, element_it);
-}
-
-/**
- * Remove needle from haystack, where both needle and elements in haystack are
- * smart pointers.
- */
-template<class Haystack, class Needle>
-void remove_from(Haystack& haystack, Needle& n)
-{
-    auto it = std::remove_if(std::begin(haystack), std::end(haystack),
-        [=] (const auto& contained)
-    {
-        return contained.get() == n.get();
-    });
-
-    haystack.erase(it, std::end(haystack));
-}
-
-/** Damage the entire view tree including the view itself. */
-void damage_views(wayfire_view view)
-{
-    for (auto view : view->enumerate_views(false))
-    {
-        view->damage();
-    }
-}
-
-struct layer_container_t;
-/**
- * Implementation of the sublayer struct.
- */
-struct sublayer_t
-{
-    /** A list of the views in the sublayer */
-    std::list<wayfire_view> views;
-
-    /** The actual layer this sublayer belongs to */
-    nonstd::observer_ptr<layer_container_t> layer;
-
-    /** The sublayer mode */
-    sublayer_mode_t mode;
-
-    /**
-     * Whether the sublayer is created artificially to hold a single view.
-     * In those cases, the sublayer is destroyed as soon as the view is moved
-     * elsewhere.
-     */
-    bool is_single_view;
-};
-
-/**
- * A container for all the sublayers of a layer.
- */
-struct layer_container_t
-{
-    /** The layer of the container */
-    layer_t layer;
-
-    using sublayer_container_t = std::list<std::unique_ptr<sublayer_t>>;
-    /** List of sublayers docked below */
-    sublayer_container_t below;
-    /** List of floating sublayers */
-    sublayer_container_t floating;
-    /** List of sublayers docked above */
-    sublayer_container_t above;
-
-    void remove_sublayer(nonstd::observer_ptr<sublayer_t> sublayer)
-    {
-        for (auto container : {& below, & floating, & above})
-        {
-            remove_from(*container, sublayer);
-        }
-    }
-};
-
-/**
- * output_layer_manager_t is a part of the workspace_manager module. It provides
- * the functionality related to layers and sublayers.
- */
-class output_layer_manager_t
-{
-    // A hierarchical representation of the view stack order
-    layer_container_t layers[TOTAL_LAYERS];
-
-    // A flat representation of the view stack order
-    std::vector<wayfire_view> view_list;
-
-  public:
-    output_layer_manager_t()
-    {
-        for (int i = 0; i < TOTAL_LAYERS; i++)
-        {
-            layers[i].layer = static_cast<layer_t>(1 << i);
-        }
-    }
-
-    constexpr int layer_index_from_mask(uint32_t layer_mask) const
-    {
-        return __builtin_ctz(layer_mask);
-    }
-
-    nonstd::observer_ptr<sublayer_t>& get_view_sublayer(wayfire_view view)
-    {
-        return view->view_impl->sublayer;
-    }
-
-    uint32_t get_view_layer(wayfire_view view)
-    {
-        /*
-         * A view might have layer data set from a previous output.
-         * That does not mean it has an assigned layer.
-         */
-        auto sublayer = get_view_sublayer(view);
-        if (!sublayer)
-        {
-            return 0;
-        }
-
-        return sublayer->layer->layer;
-    }
-
-    void remove_view(wayfire_view view)
-    {
-        auto& sublayer = get_view_sublayer(view);
-        if (!sublayer)
-        {
-            return;
-        }
-
-        damage_views(view);
-
-        remove_from(sublayer->views, view);
-        if (sublayer->is_single_view)
-        {
-            sublayer->layer->remove_sublayer(sublayer);
-        }
-
-        /* Reset the view's sublayer */
-        sublayer = nullptr;
-        rebuild_stack_order();
-    }
-
-    void add_view_to_sublayer(wayfire_view view,
-        nonstd::observer_ptr<sublayer_t> sublayer)
-    {
-        remove_view(view);
-        get_view_sublayer(view) = sublayer;
-        sublayer->views.push_front(view);
-        rebuild_stack_order();
-    }
-
-    nonstd::observer_ptr<sublayer_t> create_sublayer(layer_t layer_mask,
-        sublayer_mode_t mode)
-    {
-        auto sublayer = std::make_unique<sublayer_t>();
-        nonstd::observer_ptr<sublayer_t> ptr{sublayer};
-
-        auto& layer = this->layers[layer_index_from_mask(layer_mask)];
-        sublayer->layer = &layer;
-        sublayer->mode  = mode;
-        sublayer->is_single_view = false;
-
-        switch (mode)
-        {
-          case SUBLAYER_DOCKED_BELOW:
-            layer.below.emplace_back(std::move(sublayer));
-            break;
-
-          case SUBLAYER_DOCKED_ABOVE:
-            layer.above.emplace_front(std::move(sublayer));
-            break;
-
-          case SUBLAYER_FLOATING:
-            layer.floating.emplace_front(std::move(sublayer));
-            break;
-        }
-
-        return ptr;
-    }
-
-    /** Add or move the view to the given layer */
-    void add_view_to_layer(wayfire_view view, layer_t layer)
-    {
-        damage_views(view);
-        add_view_to_sublayer(view, create_sublayer(layer, SUBLAYER_FLOATING));
-        rebuild_stack_order();
-        damage_views(view);
-    }
-
-    /** Precondition: view is in some sublayer */
-    void bring_to_front(wayfire_view view)
-    {
-        auto sublayer = get_view_sublayer(view);
-        assert(sublayer);
-
-        for (auto view : sublayer->views)
-        {
-            damage_views(view);
-        }
-
-        if (sublayer->mode == SUBLAYER_FLOATING)
-        {
-            raise_to_front(sublayer->layer->floating, sublayer);
-        }
-
-        raise_to_front(sublayer->views, view);
-        rebuild_stack_order();
-    }
-
-    wayfire_view get_front_view(wf::layer_t layer)
-    {
-        auto views = get_views_in_layer(layer);
-        if (views.size() == 0)
-        {
-            return nullptr;
-        }
-
-        return views.front();
-    }
-
-    /** Precondition: view and below are in the same layer */
-    void restack_above(wayfire_view view, wayfire_view below)
-    {
-        damage_views(view);
-
-        auto view_sublayer  = get_view_sublayer(view);
-        auto below_sublayer = get_view_sublayer(below);
-        assert(view_sublayer->layer == below_sublayer->layer);
-
-        if (view_sublayer == below_sublayer)
-        {
-            reorder_above(view_sublayer->views, view, below);
-            rebuild_stack_order();
-
-            return;
-        }
-
-        if ((view_sublayer->mode != SUBLAYER_FLOATING) ||
-            (below_sublayer->mode != SUBLAYER_FLOATING))
-        {
-            return;
-        }
-
-        reorder_above(view_sublayer->layer->floating, view_sublayer, below_sublayer);
-        raise_to_front(view_sublayer->views, view, true); // bring to back == reverse
-        rebuild_stack_order();
-    }
-
-    /** Precondition: view and above are in the same layer */
-    void restack_below(wayfire_view view, wayfire_view above)
-    {
-        damage_views(view);
-
-        auto view_sublayer  = get_view_sublayer(view);
-        auto above_sublayer = get_view_sublayer(above);
-        assert(view_sublayer->layer == above_sublayer->layer);
-
-        if (view_sublayer == above_sublayer)
-        {
-            reorder_below(view_sublayer->views, view, above);
-            rebuild_stack_order();
-
-            return;
-        }
-
-        if ((view_sublayer->mode != SUBLAYER_FLOATING) ||
-            (above_sublayer->mode != SUBLAYER_FLOATING))
-        {
-            return;
-        }
-
-        reorder_below(view_sublayer->layer->floating, view_sublayer, above_sublayer);
-        raise_to_front(view_sublayer->views, view);
-        rebuild_stack_order();
-    }
-
-    enum class promoted_state_t
-    {
-        PROMOTED,
-        NOT_PROMOTED,
-        ANY,
-    };
-
-    void push_views(std::vector<wayfire_view>& into, layer_t layer_e,
-        promoted_state_t desired_promoted)
-    {
-        auto& layer = this->layers[layer_index_from_mask(layer_e)];
-        for (const auto& sublayers :
-             {& layer.above, & layer.floating, & layer.below})
-        {
-            for (const auto& sublayer : *sublayers)
-            {
-                auto& container = sublayer->views;
-                std::copy_if(container.begin(), container.end(),
-                    std::back_inserter(into), [=] (wayfire_view view)
-                {
-                    if (desired_promoted == promoted_state_t::ANY)
-                    {
-                        return true;
-                    }
-
-                    const bool wants_promoted =
-                        (desired_promoted == promoted_state_t::PROMOTED);
-                    return view->view_impl->is_promoted == wants_promoted;
-                });
-            }
-        }
-    }
-
-    void rebuild_stack_order()
-    {
-        this->view_list = _get_views_in_layer(VISIBLE_LAYERS);
-    }
-
-    std::vector<wayfire_view> get_views_in_layer(uint32_t layers_mask)
-    {
-        if (layers_mask == VISIBLE_LAYERS)
-        {
-            return view_list;
-        } else
-        {
-            return _get_views_in_layer(layers_mask);
-        }
-    }
-
-    std::vector<wayfire_view> _get_views_in_layer(uint32_t layers_mask)
-    {
-        std::vector<wayfire_view> views;
-        auto try_push = [&] (layer_t layer,
-                             promoted_state_t state = promoted_state_t::ANY)
-        {
-            if (!(layer & layers_mask))
-            {
-                return;
-            }
-
-            push_views(views, layer, state);
-        };
-
-        /* Above fullscreen views */
-        for (auto layer : {LAYER_DESKTOP_WIDGET, LAYER_LOCK, LAYER_UNMANAGED})
-        {
-            try_push(layer);
-        }
-
-        /* Fullscreen */
-        try_push(LAYER_WORKSPACE, promoted_state_t::PROMOTED);
-
-        /* Top layer between fullscreen and workspace */
-        try_push(LAYER_TOP);
-
-        /* Non-promoted views */
-        try_push(LAYER_WORKSPACE, promoted_state_t::NOT_PROMOTED);
-
-        /* Below fullscreen */
-        for (auto layer :
-             {LAYER_BOTTOM, LAYER_BACKGROUND, LAYER_MINIMIZED})
-        {
-            try_push(layer);
-        }
-
-        return views;
-    }
-
-    std::vector<wayfire_view> get_promoted_views()
-    {
-        std::vector<wayfire_view> views;
-        push_views(views, LAYER_WORKSPACE, promoted_state_t::PROMOTED);
-
-        return views;
-    }
-
-    /**
-     * @return A list of all views in the given sublayer.
-     */
-    std::vector<wayfire_view> get_views_in_sublayer(
-        nonstd::observer_ptr<sublayer_t> sublayer)
-    {
-        std::vector<wayfire_view> result;
-        std::copy(sublayer->views.begin(), sublayer->views.end(),
-            std::back_inserter(result));
-
-        return result;
-    }
-
-    void destroy_sublayer(nonstd::observer_ptr<sublayer_t> sublayer)
-    {
-        for (auto& view : get_views_in_sublayer(sublayer))
-        {
-            add_view_to_layer(view, sublayer->layer->layer);
-        }
-
-        sublayer->layer->remove_sublayer(sublayer);
-    }
-};
-
 struct default_workspace_implementation_t : public workspace_implementation_t
 {
     bool view_movable(wayfire_view view)
@@ -488,6 +57,23 @@ class output_viewport_manager_t
     int current_vy = 0;
 
     output_t *output;
+    output_layer_manager_t *layer_manager;
+
+    /**
+     * The wm geometry of the views in the layers, indexed by its position in
+     * the workspace grid.
+     *
+     * Sticky views and views with transformers can be visible anywhere, so
+     * they are not in the index but in unindexed_views.
+     */
+    workspace_index_t<view_interface_t*> view_index;
+    std::unordered_set<view_interface_t*> unindexed_views;
+
+    wf::signal_connection_t on_view_changed = [=] (wf::signal_data_t *data)
+    {
+        update_view_index(get_signaled_view(data));
+        layer_manager->views_moved();
+    };
 
     // Grid size was set by a plugin?
     bool has_custom_grid_size = false;
@@ -550,9 +136,11 @@ class output_viewport_manager_t
     }
 
   public:
-    output_viewport_manager_t(output_t *output)
+    output_viewport_manager_t(output_t *output,
+        output_layer_manager_t *layer_manager)
     {
         this->output = output;
+        this->layer_manager = layer_manager;
 
         vwidth_opt.set_callback(update_cfg_grid_size);
         vheight_opt.set_callback(update_cfg_grid_size);
@@ -572,9 +160,29 @@ class output_viewport_manager_t
         wf::geometry_t workspace_relative_geometry;
         wlr_box view_bbox = view->get_bounding_box();
 
-        for (int horizontal = 0; horizontal < grid.width; horizontal++)
+        /* With a positive threshold, only the workspaces which overlap the
+         * bounding box can contain enough of the view */
+        wf::point_t first = {0, 0};
+        wf::point_t last  = {grid.width - 1, grid.height - 1};
+        if ((threshold > 0) && (view_bbox.width > 0) && (view_bbox.height > 0))
+        {
+            auto screen = output->get_screen_size();
+            auto to_ws  = [] (double coord, int size)
+            {
+                return (int)std::floor(coord / size);
+            };
+
+            int x1 = view_bbox.x, x2 = view_bbox.x + view_bbox.width - 1;
+            int y1 = view_bbox.y, y2 = view_bbox.y + view_bbox.height - 1;
+            first.x = std::max(first.x, current_vx + to_ws(x1, screen.width));
+            first.y = std::max(first.y, current_vy + to_ws(y1, screen.height));
+            last.x  = std::min(last.x, current_vx + to_ws(x2, screen.width));
+            last.y  = std::min(last.y, current_vy + to_ws(y2, screen.height));
+        }
+
+        for (int horizontal = first.x; horizontal <= last.x; horizontal++)
         {
-            for (int vertical = 0; vertical < grid.height; vertical++)
+            for (int vertical = first.y; vertical <= last.y; vertical++)
             {
                 wf::point_t ws = {horizontal, vertical};
                 if (output->workspace->view_visible_on(view, ws))
@@ -678,20 +286,94 @@ class output_viewport_manager_t
         }
     }
 
+    /** Start keeping track of the geometry of a view added to the layers */
+    void track_view(wayfire_view view)
+    {
+        if (!view_index.contains(view.get()) && !unindexed_views.count(view.get()))
+        {
+            view->connect_signal("geometry-changed", &on_view_changed);
+            view->connect_signal("set-sticky", &on_view_changed);
+            view->connect_signal("transformer-changed", &on_view_changed);
+        }
+
+        update_view_index(view);
+    }
+
+    /** Stop keeping track of a view removed from the layers */
+    void untrack_view(wayfire_view view)
+    {
+        view->disconnect_signal(&on_view_changed);
+        view_index.remove(view.get());
+        unindexed_views.erase(view.get());
+    }
+
+    void update_view_index(wayfire_view view)
+    {
+        if (view->sticky || view->has_transformer())
+        {
+            view_index.remove(view.get());
+            unindexed_views.insert(view.get());
+            return;
+        }
+
+        unindexed_views.erase(view.get());
+        view_index.update(view.get(), view->get_wm_geometry());
+    }
+
+    /** @return The geometry of the workspace, relative to the current one */
+    wf::geometry_t get_workspace_box(wf::point_t ws)
+    {
+        auto g = output->get_relative_geometry();
+        g.x += (ws.x - current_vx) * g.width;
+        g.y += (ws.y - current_vy) * g.height;
+        return g;
+    }
+
+    /**
+     * Call func for each view in the layers which might be visible in the
+     * given box, relative to the current workspace. The order of the views
+     * is unspecified, and func must not change the layers.
+     */
+    template<class Func>
+    void for_each_view_candidate(wf::geometry_t box, Func func)
+    {
+        /* The index uses workspaces as cells */
+        view_index.set_screen_size(output->get_screen_size());
+        view_index.for_each_intersecting(box, [&] (view_interface_t *view)
+        {
+            func(nonstd::make_observer(view));
+        });
+
+        for (auto& view : unindexed_views)
+        {
+            func(nonstd::make_observer(view));
+        }
+    }
+
     std::vector<wayfire_view> get_views_on_workspace(wf::point_t vp,
         uint32_t layers_mask)
     {
-        /* get all views in the given layers */
-        std::vector<wayfire_view> views =
-            output->workspace->get_views_in_layer(layers_mask);
-
-        /* remove those which aren't visible on the workspace */
-        auto it = std::remove_if(views.begin(), views.end(), [&] (wayfire_view view)
+        /* Only the views in the index which overlap the workspace and the
+         * views which are not in the index can be visible on it */
+        std::vector<std::pair<size_t, wayfire_view>> visible;
+        for_each_view_candidate(get_workspace_box(vp), [&] (wayfire_view view)
         {
-            return !view_visible_on(view, vp);
+            if ((layer_manager->get_view_layer(view) & layers_mask) &&
+                view_visible_on(view, vp))
+            {
+                visible.push_back({layer_manager->get_stack_position(view), view});
+            }
         });
 
-        views.erase(it, views.end());
+        std::sort(visible.begin(), visible.end(),
+            [] (const auto& a, const auto& b) { return a.first < b.first; });
+
+        std::vector<wayfire_view> views;
+        views.reserve(visible.size());
+        for (auto& [position, view] : visible)
+        {
+            views.push_back(view);
+        }
 
         return views;
     }
@@ -783,6 +465,12 @@ class output_viewport_manager_t
         current_vx = nws.x;
         current_vy = nws.y;
 
+        /* Views which are not moved below, e.g fixed views or views outside
+         * of the middle layers, stay on the new current workspace. The moved
+         * views update their box when their geometry changes. */
+        view_index.set_current_workspace(nws);
+        layer_manager->views_moved();
+
         auto screen = output->get_screen_size();
         auto dx     = (data.old_viewport.x - nws.x) * screen.width;
         auto dy     = (data.old_viewport.y - nws.y) * screen.height;
@@ -998,7 +686,7 @@ class workspace_manager::impl
 
     impl(output_t *o) :
         layer_manager(),
-        viewport_manager(o),
+        viewport_manager(o, &layer_manager),
         workarea_manager(o)
     {
         output = o;
@@ -1090,6 +778,8 @@ class workspace_manager::impl
             view->view_impl->is_promoted = false;
         }
 
+        /* The stack order of the workspace layer depends on promotion */
+        layer_manager.rebuild_stack_order();
         auto views = viewport_manager.get_views_on_workspace(
             vp, LAYER_WORKSPACE);
 
@@ -1128,6 +818,7 @@ class workspace_manager::impl
         assert(view->get_output() == output);
         bool first_add = layer_manager.get_view_layer(view) == 0;
         layer_manager.add_view_to_layer(view, layer);
+        viewport_manager.track_view(view);
         update_promoted_views();
 
         if (first_add)
@@ -1142,6 +833,7 @@ class workspace_manager::impl
         assert(view->get_output() == output);
         bool first_add = layer_manager.get_view_layer(view) == 0;
         layer_manager.add_view_to_sublayer(view, sublayer);
+        viewport_manager.track_view(view);
         update_promoted_views();
         if (first_add)
         {
@@ -1214,6 +906,7 @@ class workspace_manager::impl
     {
         uint32_t view_layer = layer_manager.get_view_layer(view);
         layer_manager.remove_view(view);
+        viewport_manager.untrack_view(view);
 
         view_layer_detached_signal data;
         data.view = view;
@@ -1322,6 +1015,16 @@ std::vector<wayfire_view> workspace_manager::get_views_in_layer(uint32_t layers_
     return pimpl->layer_manager.get_views_in_layer(layers_mask);
 }
 
+view_span_t workspace_manager::get_views_in_layer_span(uint32_t layers_mask)
+{
+    return view_span_t{pimpl->layer_manager.get_stack_snapshot(layers_mask)};
+}
+
+uint64_t workspace_manager::get_stack_generation()
+{
+    return pimpl->layer_manager.get_stack_generation();
+}
+
 std::vector<wayfire_view> workspace_manager::get_views_in_sublayer(
     nonstd::observer_ptr<sublayer_t> sublayer)
 {
@@ -1,5 +1,7 @@
 #include <wayfire/region.hpp>
 #include <wayfire/nonstd/wlroots-full.hpp>
+#include <algorithm>
+#include <vector>
 
 /* Pixman helpers */
 wlr_box wlr_box_from_pixman_box(const pixman_box32_t& box)
@@ -91,6 +93,82 @@ void wf::region_t::expand_edges(int amount)
     wlr_region_expand(this->to_pixman(), this->to_pixman(), amount);
 }
 
+static int32_t align_down(int32_t value, int32_t alignment)
+{
+    return value - (((value % alignment) + alignment) % alignment);
+}
+
+static int32_t align_up(int32_t value, int32_t alignment)
+{
+    return align_down(value + alignment - 1, alignment);
+}
+
+static uint64_t get_area(const pixman_box32_t *boxes, int n)
+{
+    uint64_t area = 0;
+    for (int i = 0; i < n; i++)
+    {
+        area += uint64_t(boxes[i].x2 - boxes[i].x1) * (boxes[i].y2 - boxes[i].y1);
+    }
+
+    return area;
+}
+
+void wf::region_t::coalesce(size_t max_rects, double max_waste)
+{
+    int n;
+    const pixman_box32_t *boxes = pixman_region32_rectangles(&_region, &n);
+    if ((max_rects == 0) || ((size_t)n <= max_rects))
+    {
+        return;
+    }
+
+    const uint64_t area = get_area(boxes, n);
+    const auto extents  = get_extents();
+    const int32_t max_size =
+        std::max(extents.x2 - extents.x1, extents.y2 - extents.y1);
+
+    std::vector<pixman_box32_t> snapped(n);
+    wf::region_t best, candidate;
+    bool have_best = false;
+
+    /* Pixman merges adjacent boxes in the same band, so snapping to a grid
+     * bounds the number of rectangles by the number of grid cells. */
+    for (int32_t grid = 8; grid < 2 * max_size; grid *= 2)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            snapped[i].x1 = align_down(boxes[i].x1, grid);
+            snapped[i].y1 = align_down(boxes[i].y1, grid);
+            snapped[i].x2 = align_up(boxes[i].x2, grid);
+            snapped[i].y2 = align_up(boxes[i].y2, grid);
+        }
+
+        pixman_region32_fini(&candidate._region);
+        pixman_region32_init_rects(&candidate._region, snapped.data(), n);
+
+        int m;
+        auto result = pixman_region32_rectangles(&candidate._region, &m);
+        const uint64_t coalesced_area = get_area(result, m);
+        if (area < coalesced_area * (1.0 - max_waste))
+        {
+            break;
+        }
+
+        std::swap(best._region, candidate._region);
+        have_best = true;
+        if ((size_t)m <= max_rects)
+        {
+            break;
+        }
+    }
+
+    if (have_best)
+    {
+        std::swap(_region, best._region);
+    }
+}
+
 pixman_box32_t wf::region_t::get_extents() const
 {
     return *pixman_region32_extents(this->unconst());
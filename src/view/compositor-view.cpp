@@ -7,6 +7,9 @@
 
 #include <glm/gtc/matrix_transform.hpp>
 
+static const wf::typed_signal_id_t<wf::view_geometry_changed_signal>
+geometry_changed_id{"geometry-changed"};
+
 /* Implementation of mirror_view_t */
 wf::mirror_view_t::mirror_view_t(wayfire_view base_view) :
     wf::view_interface_t()
@@ -103,7 +106,7 @@ void wf::mirror_view_t::move(int x, int y)
     this->y = y;
 
     damage();
-    emit_signal("geometry-changed", &data);
+    emit_signal(geometry_changed_id, &data);
 }
 
 wf::geometry_t wf::mirror_view_t::get_output_geometry()
@@ -245,7 +248,7 @@ void wf::color_rect_view_t::move(int x, int y)
     this->geometry.y = y;
 
     damage();
-    emit_signal("geometry-changed", &data);
+    emit_signal(geometry_changed_id, &data);
 }
 
 void wf::color_rect_view_t::resize(int w, int h)
@@ -258,7 +261,7 @@ void wf::color_rect_view_t::resize(int w, int h)
     this->geometry.height = h;
 
     damage();
-    emit_signal("geometry-changed", &data);
+    emit_signal(geometry_changed_id, &data);
 }
 
 wf::geometry_t wf::color_rect_view_t::get_output_geometry()
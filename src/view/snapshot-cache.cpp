@@ -0,0 +1,161 @@
+#include "snapshot-cache.hpp"
+#include "view-impl.hpp"
+
+#include <algorithm>
+#include <vector>
+
+static size_t get_buffer_bytes(const wf::framebuffer_base_t& buffer)
+{
+    if (buffer.fb == (uint32_t)-1)
+    {
+        return 0;
+    }
+
+    return (size_t)buffer.viewport_width * buffer.viewport_height * 4;
+}
+
+/** Get the size of the buffers of the view which can be freed. */
+static size_t get_evictable_bytes(wf::view_interface_t *view)
+{
+    auto& impl   = *view->view_impl;
+    size_t bytes = 0;
+    if (view->is_mapped())
+    {
+        bytes += get_buffer_bytes(impl.offscreen_buffer);
+    }
+
+    for (auto& lod : impl.lod_snapshots)
+    {
+        bytes += get_buffer_bytes(*lod);
+    }
+
+    impl.transforms.for_each([&] (auto& block)
+    {
+        bytes += get_buffer_bytes(block->fb);
+    });
+
+    return bytes;
+}
+
+wf::snapshot_cache_t& wf::snapshot_cache_t::get()
+{
+    /* Never destroyed, because the option wrappers must not outlive the
+     * config */
+    static auto cache = new snapshot_cache_t;
+    return *cache;
+}
+
+void wf::snapshot_cache_t::touch(wf::view_interface_t *view)
+{
+    auto& usage = view->view_impl->snapshot_usage;
+    usage.last_used   = ++touch_serial;
+    usage.idle_frames = 0;
+    views.insert(view);
+}
+
+void wf::snapshot_cache_t::forget(wf::view_interface_t *view)
+{
+    views.erase(view);
+}
+
+void wf::snapshot_cache_t::frame_done(wf::output_t *output)
+{
+    std::vector<usage_entry_t> entries;
+    entries.reserve(views.size());
+    for (auto view : views)
+    {
+        auto& usage = view->view_impl->snapshot_usage;
+        if (view->get_output() == output)
+        {
+            ++usage.idle_frames;
+        }
+
+        entries.push_back({view, view->get_output(), get_evictable_bytes(view),
+            usage.last_used, usage.idle_frames});
+    }
+
+    size_t limit = (size_t)std::max(0, (int)max_cache_size) * 1024 * 1024;
+    auto evicted = choose_evictions(std::move(entries), output, limit,
+        std::max(1, (int)max_idle_frames));
+    for (auto view : evicted)
+    {
+        evict(view);
+    }
+}
+
+std::vector<wf::view_interface_t*> wf::snapshot_cache_t::choose_evictions(
+    std::vector<usage_entry_t> entries, wf::output_t *output, size_t limit,
+    uint32_t max_idle_frames)
+{
+    std::vector<wf::view_interface_t*> evicted;
+    size_t total = 0;
+    auto it = std::remove_if(entries.begin(), entries.end(),
+        [&] (const usage_entry_t& entry)
+    {
+        if ((entry.output == output) && (entry.idle_frames > max_idle_frames))
+        {
+            evicted.push_back(entry.view);
+            return true;
+        }
+
+        total += entry.bytes;
+        return false;
+    });
+    entries.erase(it, entries.end());
+
+    if (total <= limit)
+    {
+        return evicted;
+    }
+
+    std::sort(entries.begin(), entries.end(),
+        [] (const usage_entry_t& a, const usage_entry_t& b)
+    {
+        return a.last_used < b.last_used;
+    });
+
+    for (auto& entry : entries)
+    {
+        if (total <= limit)
+        {
+            break;
+        }
+
+        /* Buffers used in the current frame are still needed. The frame of
+         * the output has already been counted for the views on it. */
+        uint32_t current_frame = (entry.output == output) ? 1 : 0;
+        if (entry.idle_frames <= current_frame)
+        {
+            continue;
+        }
+
+        total -= entry.bytes;
+        evicted.push_back(entry.view);
+    }
+
+    return evicted;
+}
+
+void wf::snapshot_cache_t::evict(wf::view_interface_t *view)
+{
+    auto& impl = *view->view_impl;
+    view->release_lod_snapshots();
+
+    OpenGL::render_begin();
+    if (view->is_mapped())
+    {
+        /* take_snapshot() renders the whole view again into a new buffer */
+        impl.offscreen_buffer.release();
+    }
+
+    impl.transforms.for_each([&] (auto& block)
+    {
+        block->fb.release();
+        block->cached_damage.clear();
+        block->damage_all = true;
+    });
+
+    OpenGL::render_end();
+
+    views.erase(view);
+}
@@ -0,0 +1,85 @@
+#ifndef WF_SNAPSHOT_CACHE_HPP
+#define WF_SNAPSHOT_CACHE_HPP
+
+#include <wayfire/view.hpp>
+#include <wayfire/option-wrapper.hpp>
+
+#include <unordered_set>
+#include <vector>
+
+namespace wf
+{
+/**
+ * Limits the GPU memory kept by the offscreen buffers of views: their
+ * snapshots, their downscaled snapshots and the cached outputs of their
+ * transformers.
+ *
+ * The buffers of a view are freed when the view has not been rendered with
+ * them for core/snapshot_idle_frames frames of its output, or when the buffers
+ * of all views exceed core/snapshot_cache_size, starting with the least
+ * recently used view. Freed buffers are damaged completely, so that they are
+ * created again when they are needed.
+ *
+ * The snapshots of unmapped views are never freed, because their contents
+ * cannot be restored.
+ */
+class snapshot_cache_t
+{
+  public:
+    /** Get the snapshot cache of the compositor. */
+    static snapshot_cache_t& get();
+
+    /** Mark the buffers of the view as used in the current frame. */
+    void touch(wf::view_interface_t *view);
+
+    /** Stop tracking the view, without freeing its buffers. */
+    void forget(wf::view_interface_t *view);
+
+    /**
+     * Free the buffers which have been idle for too long or exceed the budget.
+     * Called after each frame of the output, outside of
+     * OpenGL::render_begin() and OpenGL::render_end().
+     */
+    void frame_done(wf::output_t *output);
+
+    /** The state of the buffers of a view, as seen by the eviction policy */
+    struct usage_entry_t
+    {
+        wf::view_interface_t *view;
+        wf::output_t *output;
+        /* The size of the buffers which can be freed */
+        size_t bytes;
+        /* Orders the views by their last use */
+        uint64_t last_used;
+        /* Frames of the view's output since the buffers were last used,
+         * including the current frame if the view is on the frame's output */
+        uint32_t idle_frames;
+    };
+
+    /**
+     * Choose the views whose buffers are freed after a frame of the given
+     * output: the views of the output which have been idle for more than
+     * max_idle_frames frames, and then the least recently used views until
+     * the total size fits in limit. Buffers used in the current frame of
+     * their output are never chosen because of the limit.
+     */
+    static std::vector<wf::view_interface_t*> choose_evictions(
+        std::vector<usage_entry_t> entries, wf::output_t *output,
+        size_t limit, uint32_t max_idle_frames);
+
+  private:
+    wf::option_wrapper_t<int> max_cache_size{"core/snapshot_cache_size"};
+    wf::option_wrapper_t<int> max_idle_frames{"core/snapshot_idle_frames"};
+
+    /* Views which have offscreen buffers */
+    std::unordered_set<wf::view_interface_t*> views;
+    uint64_t touch_serial = 0;
+
+    snapshot_cache_t() = default;
+
+    /** Free the buffers of the view and stop tracking it. */
+    void evict(wf::view_interface_t *view);
+};
+}
+
+#endif /* end of include guard: WF_SNAPSHOT_CACHE_HPP */
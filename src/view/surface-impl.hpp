@@ -23,6 +23,19 @@ class surface_interface_t::impl
     wf::output_t *output = nullptr;
     static int active_shrink_constraint;
 
+    /**
+     * Incremented whenever the area in which some surface accepts input may
+     * have moved: when surfaces are (un)mapped, subsurfaces are added or
+     * removed, or a commit changes the size of a surface or the position of
+     * its subsurfaces. Commits which only change the contents of surfaces
+     * do not increment it. See update_input_serial().
+     */
+    static uint64_t input_serial;
+
+    /* The position and size of the surface when update_input_serial() was
+     * last called for it or its parent */
+    wf::geometry_t input_box = {0, 0, 0, 0};
+
     /**
      * Most surfaces don't have a wlr_surface. However, internal surface
      * implementations can set the underlying surface so that functions like
@@ -30,8 +43,30 @@ class surface_interface_t::impl
      * subtract_opaque(), send_frame_done(), etc. work for the surface
      */
     wlr_surface *wsurface = nullptr;
+
+    /**
+     * The time (in milliseconds) when the last frame event was sent to the
+     * surface. Used to throttle frame events for occluded surfaces.
+     */
+    uint32_t last_frame_done = 0;
+
+    /**
+     * Whether simple_render() is implemented by the core, which changes the
+     * GL state only through the OpenGL helpers. See render_surface().
+     */
+    bool core_render = false;
 };
 
+/**
+ * Increment surface_interface_t::impl::input_serial if the size of the surface
+ * or the position or size of its direct subsurfaces changed since the last
+ * call. Called whenever the surface is committed.
+ *
+ * The input region itself is not compared, as the hit-test cache queries it
+ * from the surfaces directly.
+ */
+void update_input_serial(surface_interface_t *surface);
+
 /**
  * A base class for views and surfaces which are based on a wlr_surface
  * Any class that derives from wlr_surface_base_t must also derive from
@@ -124,6 +159,14 @@ class wlr_child_surface_base_t :
         surface_interface_t::set_output(output);
     }
 };
+
+/**
+ * Call the surface's simple_render(). Surfaces which are not implemented by
+ * the core may change the GL state in any way, so they are rendered with the
+ * GL state tracking suspended.
+ */
+void render_surface(surface_interface_t *surface, const wf::framebuffer_t& fb,
+    int x, int y, const wf::region_t& damage);
 }
 
 #endif /* end of include guard: SURFACE_IMPL_HPP */
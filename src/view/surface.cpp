@@ -5,6 +5,7 @@
 #include "subsurface.hpp"
 #include "wayfire/opengl.hpp"
 #include "../core/core-impl.hpp"
+#include "../core/opengl-priv.hpp"
 #include "wayfire/output.hpp"
 #include <wayfire/util/log.hpp>
 #include "wayfire/render-manager.hpp"
@@ -32,6 +33,7 @@ void wf::surface_interface_t::add_subsurface(
     ev.subsurface   = {subsurface};
 
     container.insert(container.begin(), std::move(subsurface));
+    ++impl::input_serial;
     this->emit_signal("subsurface-added", &ev);
 }
 
@@ -57,6 +59,7 @@ std::unique_ptr<wf::surface_interface_t> wf::surface_interface_t::remove_subsurf
     ev.main_surface = this;
     ev.subsurface   = subsurface;
     this->emit_signal("subsurface-removed", &ev);
+    ++impl::input_serial;
 
     if (auto surf = remove_from(priv->surface_children_above))
     {
@@ -79,39 +82,48 @@ wf::surface_interface_t*wf::surface_interface_t::get_main_surface()
     return this;
 }
 
-std::vector<wf::surface_iterator_t> wf::surface_interface_t::enumerate_surfaces(
-    wf::point_t surface_origin)
+void wf::surface_interface_t::visit_surfaces(wf::point_t surface_origin,
+    void *data, surface_visitor_t visitor)
 {
-    std::vector<wf::surface_iterator_t> result;
-    result.reserve(priv->last_cnt_surfaces);
-    auto add_surfaces_recursive = [&] (surface_interface_t *child)
+    for (auto& child : priv->surface_children_above)
     {
-        if (!child->is_mapped())
+        if (child->is_mapped())
         {
-            return;
+            child->visit_surfaces(child->get_offset() + surface_origin,
+                data, visitor);
         }
-
-        auto child_surfaces = child->enumerate_surfaces(
-            child->get_offset() + surface_origin);
-        result.insert(result.end(),
-            child_surfaces.begin(), child_surfaces.end());
-    };
-
-    for (auto& child : priv->surface_children_above)
-    {
-        add_surfaces_recursive(child.get());
     }
 
     if (is_mapped())
     {
-        result.push_back({this, surface_origin});
+        visitor(data, {this, surface_origin});
     }
 
     for (auto& child : priv->surface_children_below)
     {
-        add_surfaces_recursive(child.get());
+        if (child->is_mapped())
+        {
+            child->visit_surfaces(child->get_offset() + surface_origin,
+                data, visitor);
+        }
     }
+}
 
+void wf::surface_interface_t::collect_surfaces(
+    std::vector<surface_iterator_t>& list, wf::point_t surface_origin)
+{
+    for_each_surface([&] (const surface_iterator_t& child)
+    {
+        list.push_back(child);
+    }, surface_origin);
+}
+
+std::vector<wf::surface_iterator_t> wf::surface_interface_t::enumerate_surfaces(
+    wf::point_t surface_origin)
+{
+    std::vector<wf::surface_iterator_t> result;
+    result.reserve(priv->last_cnt_surfaces);
+    collect_surfaces(result, surface_origin);
     priv->last_cnt_surfaces = result.size();
     return result;
 }
@@ -137,6 +149,7 @@ void wf::surface_interface_t::set_output(wf::output_t *output)
 
 /* Static method */
 int wf::surface_interface_t::impl::active_shrink_constraint = 0;
+uint64_t wf::surface_interface_t::impl::input_serial = 0;
 
 void wf::surface_interface_t::set_opaque_shrink_constraint(
     std::string constraint_name, int value)
@@ -232,6 +245,7 @@ void wf::surface_interface_t::damage_surface_box(const wlr_box& box)
 
 void wf::surface_interface_t::clear_subsurfaces()
 {
+    ++impl::input_serial;
     subsurface_removed_signal ev;
     ev.main_surface = this;
     const auto& finish_subsurfaces = [&] (auto& container)
@@ -311,6 +325,7 @@ wf::dimensions_t wf::wlr_surface_base_t::_get_size() const
 
 void wf::emit_map_state_change(wf::surface_interface_t *surface)
 {
+    ++surface_interface_t::impl::input_serial;
     std::string state =
         surface->is_mapped() ? "surface-mapped" : "surface-unmapped";
 
@@ -397,8 +412,43 @@ void wf::wlr_surface_base_t::apply_surface_damage()
     _as_si->damage_surface_region(dmg);
 }
 
+/** Update the input box of the surface, returns whether it changed */
+static bool update_input_box(wf::surface_interface_t *surface)
+{
+    auto offset = surface->get_offset();
+    auto size   = surface->get_size();
+    wf::geometry_t box = {offset.x, offset.y, size.width, size.height};
+    if (box == surface->priv->input_box)
+    {
+        return false;
+    }
+
+    surface->priv->input_box = box;
+    return true;
+}
+
+void wf::update_input_serial(surface_interface_t *surface)
+{
+    /* The positions of subsurfaces are applied when their parent commits */
+    bool changed = update_input_box(surface);
+    for (auto container : {&surface->priv->surface_children_above,
+                           &surface->priv->surface_children_below})
+    {
+        for (auto& child : *container)
+        {
+            changed |= update_input_box(child.get());
+        }
+    }
+
+    if (changed)
+    {
+        ++surface_interface_t::impl::input_serial;
+    }
+}
+
 void wf::wlr_surface_base_t::commit()
 {
+    update_input_serial(_as_si);
     apply_surface_damage();
     if (_as_si->get_output())
     {
@@ -436,21 +486,28 @@ void wf::wlr_surface_base_t::_simple_render(const wf::framebuffer_t& fb,
     wf::texture_t texture{surface};
 
     OpenGL::render_begin(fb);
-    OpenGL::render_texture(texture, fb, geometry, glm::vec4(1.f),
-        OpenGL::RENDER_FLAG_CACHED);
-    for (const auto& rect : damage)
-    {
-        fb.logic_scissor(wlr_box_from_pixman_box(rect));
-        OpenGL::draw_cached();
-    }
-
-    OpenGL::clear_cached();
+    OpenGL::render_texture(texture, fb, geometry, damage);
     OpenGL::render_end();
 }
 
 wf::wlr_child_surface_base_t::wlr_child_surface_base_t(
     surface_interface_t *self) : wlr_surface_base_t(self)
-{}
+{
+    priv->core_render = true;
+}
+
+void wf::render_surface(surface_interface_t *surface,
+    const wf::framebuffer_t& fb, int x, int y, const wf::region_t& damage)
+{
+    if (surface->priv->core_render)
+    {
+        surface->simple_render(fb, x, y, damage);
+        return;
+    }
+
+    OpenGL::untracked_scope_t plugin_gl;
+    surface->simple_render(fb, x, y, damage);
+}
 
 wf::wlr_child_surface_base_t::~wlr_child_surface_base_t()
 {}
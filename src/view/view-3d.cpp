@@ -4,6 +4,7 @@
 #include "wayfire/output.hpp"
 #include <algorithm>
 #include <cmath>
+#include <typeinfo>
 
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -175,6 +176,35 @@ void wf::view_2D::render_box(wf::texture_t src_tex, wlr_box src_box,
     OpenGL::render_end();
 }
 
+bool wf::view_2D::get_affine_transform(wf::geometry_t view,
+    glm::mat4& transform, glm::vec4& color)
+{
+    if (typeid(*this) != typeid(wf::view_2D))
+    {
+        return false;
+    }
+
+    get_2D_transform(transform, color);
+    return true;
+}
+
+void wf::view_2D::get_2D_transform(glm::mat4& transform, glm::vec4& color)
+{
+    /* Same as transform_point(), but in coordinates with the Y axis pointing
+     * down, where the rotation goes in the opposite direction */
+    auto wm_geom = view->transform_region(view->get_wm_geometry(), this);
+    glm::vec3 center(wm_geom.x + wm_geom.width / 2.0,
+        wm_geom.y + wm_geom.height / 2.0, 0.0);
+
+    transform = glm::translate(glm::mat4(1.0),
+        center + glm::vec3{translation_x, translation_y, 0.0});
+    transform = glm::rotate(transform, -angle, {0, 0, 1});
+    transform = glm::scale(transform, {scale_x, scale_y, 1.0});
+    transform = glm::translate(transform, -center);
+
+    color = {1.0f, 1.0f, 1.0f, alpha};
+}
+
 const float wf::view_3D::fov = PI / 4;
 glm::mat4 wf::view_3D::default_view_matrix()
 {
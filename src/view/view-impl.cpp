@@ -9,9 +9,17 @@
 
 #include "xdg-shell.hpp"
 
+/* Emitted on every move and resize of a view */
+static const wf::typed_signal_id_t<wf::view_geometry_changed_signal>
+geometry_changed_id{"geometry-changed"};
+static const wf::typed_signal_id_t<wf::view_geometry_changed_signal>
+view_geometry_changed_id{"view-geometry-changed"};
+
 wf::wlr_view_t::wlr_view_t() :
     wf::wlr_surface_base_t(this), wf::view_interface_t()
-{}
+{
+    priv->core_render = true;
+}
 
 void wf::wlr_view_t::set_role(view_role_t new_role)
 {
@@ -124,17 +132,21 @@ void wf::wlr_view_t::set_position(int x, int y,
     {
         view_impl->offscreen_buffer.geometry.x += x - data.old_geometry.x;
         view_impl->offscreen_buffer.geometry.y += y - data.old_geometry.y;
+        for (auto& lod : view_impl->lod_snapshots)
+        {
+            lod->geometry = view_impl->offscreen_buffer.geometry;
+        }
     }
 
     damage();
 
     if (send_signal)
     {
-        emit_signal("geometry-changed", &data);
-        wf::get_core().emit_signal("view-geometry-changed", &data);
+        emit_signal(geometry_changed_id, &data);
+        wf::get_core().emit_signal(view_geometry_changed_id, &data);
         if (get_output())
         {
-            get_output()->emit_signal("view-geometry-changed", &data);
+            get_output()->emit_signal(view_geometry_changed_id, &data);
         }
     }
 
@@ -194,11 +206,11 @@ void wf::wlr_view_t::update_size()
     /* Damage new size */
     last_bounding_box = get_bounding_box();
     view_damage_raw(self(), last_bounding_box);
-    emit_signal("geometry-changed", &data);
-    wf::get_core().emit_signal("view-geometry-changed", &data);
+    emit_signal(geometry_changed_id, &data);
+    wf::get_core().emit_signal(view_geometry_changed_id, &data);
     if (get_output())
     {
-        get_output()->emit_signal("view-geometry-changed", &data);
+        get_output()->emit_signal(view_geometry_changed_id, &data);
     }
 
     if (view_impl->frame)
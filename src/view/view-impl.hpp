@@ -1,7 +1,7 @@
 #ifndef VIEW_IMPL_HPP
 #define VIEW_IMPL_HPP
 
-#include <wayfire/nonstd/safe-list.hpp>
+#include <wayfire/nonstd/safe-vector.hpp>
 #include <wayfire/view.hpp>
 #include <wayfire/opengl.hpp>
 
@@ -20,8 +20,21 @@ struct view_transform_block_t
 {
     std::string plugin_name = "";
     std::unique_ptr<wf::view_transformer_t> transform;
+    /* The cached output of the transformer, if it is the last one of a
+     * rendering pass, but not of the whole chain */
     wf::framebuffer_t fb;
 
+    /* The parts of the view which have changed since fb was last rendered.
+     * Only used for the first transformer, the damage of the next ones is
+     * derived from it while rendering. */
+    wf::region_t cached_damage;
+    /* Set if fb needs to be rendered again completely */
+    bool damage_all = true;
+    /* The transform and color fb was rendered with, if the transformer is the
+     * last one of a composed pass */
+    glm::mat4 cached_transform{1.0};
+    glm::vec4 cached_color{1.0};
+
     view_transform_block_t();
     ~view_transform_block_t();
 
@@ -45,6 +58,8 @@ class view_interface_t::view_priv_impl
     int ref_cnt = 0;
 
     size_t last_view_cnt = 0;
+    /** The surfaces rendered in the last snapshot, reused between snapshots */
+    std::vector<wf::surface_iterator_t> snapshot_surfaces;
 
     bool keyboard_focus_enabled = true;
 
@@ -59,6 +74,12 @@ class view_interface_t::view_priv_impl
      */
     void update_windowed_geometry(wayfire_view self, wf::geometry_t geometry);
 
+    /**
+     * Add damage in the coordinates of the untransformed view to the snapshot
+     * and to the input of the first transformer.
+     */
+    void cache_damage(const wlr_box& box);
+
     std::unique_ptr<wf::decorator_frame_t_t> frame = nullptr;
 
     uint32_t edges = 0;
@@ -66,7 +87,7 @@ class view_interface_t::view_priv_impl
     int in_continuous_resize = 0;
     int visibility_counter   = 1;
 
-    wf::safe_list_t<std::shared_ptr<view_transform_block_t>> transforms;
+    wf::safe_vector_t<std::shared_ptr<view_transform_block_t>> transforms;
 
     struct offscreen_buffer_t : public wf::framebuffer_t
     {
@@ -77,8 +98,35 @@ class view_interface_t::view_priv_impl
         }
     } offscreen_buffer;
 
+    /* Downscaled copies of the snapshot, each half the size of the previous
+     * one. See take_lod_snapshot(). */
+    std::vector<std::unique_ptr<offscreen_buffer_t>> lod_snapshots;
+
     wlr_box minimize_hint = {0, 0, 0, 0};
 
+    /* Bookkeeping of the snapshot cache, see snapshot_cache_t */
+    struct snapshot_usage_t
+    {
+        /* Orders the views by their last use */
+        uint64_t last_used = 0;
+        /* Frames of the output since the buffers were last used */
+        uint32_t idle_frames = 0;
+    } snapshot_usage;
+
+    /**
+     * The bounding box and the transformed opaque region of the view, cached
+     * by the render manager for the duration of a single repaint.
+     * A serial of 0 means that the value has not been computed yet.
+     */
+    struct coverage_t
+    {
+        uint64_t bbox_serial = 0;
+        wf::geometry_t bbox;
+
+        uint64_t opaque_serial = 0;
+        wf::region_t opaque;
+    } coverage;
+
     /** The sublayer of the view. For workspace-manager. */
     nonstd::observer_ptr<sublayer_t> sublayer;
     /* Promoted to the fullscreen layer? For workspace-manager. */
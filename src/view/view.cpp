@@ -1,6 +1,8 @@
 #include <wayfire/util/log.hpp>
 #include "../core/core-impl.hpp"
+#include "../core/opengl-priv.hpp"
 #include "view-impl.hpp"
+#include "snapshot-cache.hpp"
 #include "wayfire/opengl.hpp"
 #include "wayfire/output.hpp"
 #include "wayfire/view.hpp"
@@ -11,6 +13,8 @@
 #include "../output/gtk-shell.hpp"
 
 #include <algorithm>
+#include <cmath>
+#include <vector>
 #include <glm/glm.hpp>
 #include "wayfire/signal-definitions.hpp"
 
@@ -148,22 +152,14 @@ void wf::view_interface_t::set_toplevel_parent(wayfire_view new_parent)
 std::vector<wayfire_view> wf::view_interface_t::enumerate_views(
     bool mapped_only)
 {
-    if (!this->is_mapped() && mapped_only)
-    {
-        return {};
-    }
-
     std::vector<wayfire_view> result;
     result.reserve(view_impl->last_view_cnt);
-    for (auto& v : this->children)
+    for_each_view([&] (wayfire_view view)
     {
-        auto cdr = v->enumerate_views(mapped_only);
-        result.insert(result.end(), cdr.begin(), cdr.end());
-    }
+        result.push_back(view);
+    }, mapped_only);
 
-    result.push_back(self());
     view_impl->last_view_cnt = result.size();
-
     return result;
 }
 
@@ -362,19 +358,28 @@ wf::surface_interface_t*wf::view_interface_t::map_input_coordinates(
     auto view_relative_coordinates =
         global_to_local_point(cursor, nullptr);
 
-    for (auto& child : enumerate_surfaces({0, 0}))
+    wf::surface_interface_t *result = nullptr;
+    for_each_surface([&] (const wf::surface_iterator_t& child)
     {
-        local.x = view_relative_coordinates.x - child.position.x;
-        local.y = view_relative_coordinates.y - child.position.y;
+        if (result)
+        {
+            return;
+        }
+
+        wf::pointf_t child_local = {
+            view_relative_coordinates.x - child.position.x,
+            view_relative_coordinates.y - child.position.y,
+        };
 
         if (child.surface->accepts_input(
-            std::floor(local.x), std::floor(local.y)))
+            std::floor(child_local.x), std::floor(child_local.y)))
         {
-            return child.surface;
+            result = child.surface;
+            local  = child_local;
         }
-    }
+    });
 
-    return nullptr;
+    return result;
 }
 
 bool wf::view_interface_t::is_focuseable() const
@@ -576,6 +581,25 @@ void wf::view_interface_t::view_priv_impl::update_windowed_geometry(
     }
 }
 
+void wf::view_interface_t::view_priv_impl::cache_damage(const wlr_box& box)
+{
+    offscreen_buffer.cached_damage |= box;
+    for (auto& lod : lod_snapshots)
+    {
+        lod->cached_damage |= box;
+    }
+
+    bool first = true;
+    transforms.for_each([&] (auto& tr)
+    {
+        if (first)
+        {
+            tr->cached_damage |= box;
+            first = false;
+        }
+    });
+}
+
 wf::geometry_t wf::view_interface_t::view_priv_impl::calculate_windowed_geometry(
     wf::output_t *output)
 {
@@ -754,13 +778,15 @@ void wf::view_interface_t::set_visible(bool visible)
         LOGE("set_visible(true) called more often than set_visible(false)!");
     }
 
+    /* Hidden views do not receive input */
+    ++wf::surface_interface_t::impl::input_serial;
     this->damage();
 }
 
 void wf::view_interface_t::damage()
 {
     auto bbox = get_untransformed_bounding_box();
-    view_impl->offscreen_buffer.cached_damage |= bbox;
+    view_impl->cache_damage(bbox);
     view_damage_raw(self(), transform_region(bbox));
 }
 
@@ -866,6 +892,7 @@ void wf::view_interface_t::add_transformer(
     auto tr = std::make_shared<wf::view_transform_block_t>();
     tr->transform   = std::move(transformer);
     tr->plugin_name = name;
+    tr->fb.owner    = "view " + std::to_string(get_id()) + " transformer " + name;
 
     view_impl->transforms.emplace_at(std::move(tr), [&] (auto& other)
     {
@@ -877,7 +904,17 @@ void wf::view_interface_t::add_transformer(
         return view_impl->transforms.INSERT_NONE;
     });
 
+    /* The input of the transformers after the new one has changed */
+    view_impl->transforms.for_each([] (auto& tr)
+    {
+        tr->damage_all = true;
+    });
+
     damage();
+
+    wf::view_transformer_changed_signal data;
+    data.view = self();
+    emit_signal("transformer-changed", &data);
 }
 
 nonstd::observer_ptr<wf::view_transformer_t> wf::view_interface_t::get_transformer(
@@ -903,6 +940,12 @@ void wf::view_interface_t::pop_transformer(
         return tr->transform.get() == transformer.get();
     });
 
+    /* The input of the transformers after the removed one has changed */
+    view_impl->transforms.for_each([] (auto& tr)
+    {
+        tr->damage_all = true;
+    });
+
     /* Since we can remove transformers while rendering the output, damaging it
      * won't help at this stage (damage is already calculated).
      *
@@ -911,6 +954,10 @@ void wf::view_interface_t::pop_transformer(
     {
         get_output()->render->damage_whole_idle();
     }
+
+    wf::view_transformer_changed_signal data;
+    data.view = self();
+    emit_signal("transformer-changed", &data);
 }
 
 void wf::view_interface_t::pop_transformer(std::string name)
@@ -933,12 +980,12 @@ wf::geometry_t wf::view_interface_t::get_untransformed_bounding_box()
     auto bbox = get_output_geometry();
     wf::region_t bounding_region = bbox;
 
-    for (auto& child : enumerate_surfaces({bbox.x, bbox.y}))
+    for_each_surface([&] (const wf::surface_iterator_t& child)
     {
         auto dim = child.surface->get_size();
         bounding_region |= {child.position.x, child.position.y,
             dim.width, dim.height};
-    }
+    }, {bbox.x, bbox.y});
 
     return wlr_box_from_pixman_box(bounding_region.get_extents());
 }
@@ -1012,19 +1059,20 @@ bool wf::view_interface_t::intersects_region(const wlr_box& region)
     }
 
     auto origin = get_output_geometry();
-    for (auto& child : enumerate_surfaces({origin.x, origin.y}))
+    bool intersects = false;
+    for_each_surface([&] (const wf::surface_iterator_t& child)
     {
-        wlr_box box = {child.position.x, child.position.y,
-            child.surface->get_size().width, child.surface->get_size().height};
-        box = transform_region(box);
-
-        if (region & box)
+        if (intersects)
         {
-            return true;
+            return;
         }
-    }
 
-    return false;
+        wlr_box box = {child.position.x, child.position.y,
+            child.surface->get_size().width, child.surface->get_size().height};
+        intersects = region & transform_region(box);
+    }, {origin.x, origin.y});
+
+    return intersects;
 }
 
 wf::region_t wf::view_interface_t::get_transformed_opaque_region()
@@ -1038,10 +1086,10 @@ wf::region_t wf::view_interface_t::get_transformed_opaque_region()
     auto og   = get_output_geometry();
 
     wf::region_t opaque;
-    for (auto& surf : enumerate_surfaces({og.x, og.y}))
+    for_each_surface([&] (const wf::surface_iterator_t& surf)
     {
         opaque |= surf.surface->get_opaque_region(surf.position);
-    }
+    }, {og.x, og.y});
 
     auto bbox = obox;
     this->view_impl->transforms.for_each(
@@ -1054,6 +1102,78 @@ wf::region_t wf::view_interface_t::get_transformed_opaque_region()
     return opaque;
 }
 
+namespace
+{
+/**
+ * A part of the transformer chain of a view which is rendered in a single
+ * pass: either a single transformer, or a run of composable transformers.
+ */
+struct transform_pass_t
+{
+    std::vector<std::shared_ptr<wf::view_transform_block_t>> blocks;
+
+    /* Whether the blocks are composable, so that the pass can be rendered with
+     * the composed transform and color */
+    bool composed = false;
+    glm::mat4 transform{1.0};
+    glm::vec4 color{1.0};
+
+    wf::geometry_t input_box;
+    wf::geometry_t output_box;
+
+    /** Get the bounding box of the given part of the input after the pass. */
+    wlr_box get_bounding_box(wlr_box region) const
+    {
+        if (!composed)
+        {
+            return blocks.front()->transform->get_bounding_box(input_box, region);
+        }
+
+        float x1 = region.x, x2 = region.x + region.width;
+        float y1 = region.y, y2 = region.y + region.height;
+        glm::vec4 corners[] = {
+            transform * glm::vec4{x1, y1, 0, 1},
+            transform * glm::vec4{x2, y1, 0, 1},
+            transform * glm::vec4{x1, y2, 0, 1},
+            transform * glm::vec4{x2, y2, 0, 1},
+        };
+
+        int bx1 = std::floor(std::min({corners[0].x, corners[1].x,
+            corners[2].x, corners[3].x}));
+        int by1 = std::floor(std::min({corners[0].y, corners[1].y,
+            corners[2].y, corners[3].y}));
+        int bx2 = std::ceil(std::max({corners[0].x, corners[1].x,
+            corners[2].x, corners[3].x}));
+        int by2 = std::ceil(std::max({corners[0].y, corners[1].y,
+            corners[2].y, corners[3].y}));
+
+        return {bx1, by1, bx2 - bx1, by2 - by1};
+    }
+
+    void render(wf::texture_t src_tex, const wf::region_t& damage,
+        const wf::framebuffer_t& target_fb) const
+    {
+        if (!composed)
+        {
+            OpenGL::untracked_scope_t transformer_gl;
+            blocks.front()->transform->render_with_damage(src_tex, input_box,
+                damage, target_fb);
+            return;
+        }
+
+        auto matrix = target_fb.get_orthographic_projection() * transform;
+        OpenGL::render_begin(target_fb);
+        for (auto& rect : damage)
+        {
+            target_fb.logic_scissor(wlr_box_from_pixman_box(rect));
+            OpenGL::render_transformed_texture(src_tex, input_box, matrix, color);
+        }
+
+        OpenGL::render_end();
+    }
+};
+}
+
 bool wf::view_interface_t::render_transformed(const wf::framebuffer_t& framebuffer,
     const wf::region_t& damage)
 {
@@ -1062,11 +1182,18 @@ bool wf::view_interface_t::render_transformed(const wf::framebuffer_t& framebuff
         return false;
     }
 
+    snapshot_cache_t::get().touch(this);
     wf::geometry_t obox = get_untransformed_bounding_box();
     wf::texture_t previous_texture;
     float texture_scale;
 
-    if (is_mapped() && (enumerate_surfaces().size() == 1) && get_wlr_surface())
+    size_t mapped_surfaces = 0;
+    for_each_surface([&] (const wf::surface_iterator_t&)
+    {
+        ++mapped_surfaces;
+    });
+
+    if (is_mapped() && (mapped_surfaces == 1) && get_wlr_surface())
     {
         /* Optimized case: there is a single mapped surface.
          * We can directly start with its texture */
@@ -1079,86 +1206,195 @@ bool wf::view_interface_t::render_transformed(const wf::framebuffer_t& framebuff
         texture_scale    = view_impl->offscreen_buffer.scale;
     }
 
-    /* We keep a shared_ptr to the previous transform which we executed, so that
-     * even if it gets removed, its texture remains valid.
-     *
-     * NB: we do not call previous_transform's transformer functions after the
-     * cycle is complete, because the memory might have already been freed.
-     * We only know that the texture is still alive. */
-    std::shared_ptr<view_transform_block_t> previous_transform = nullptr;
+    /* Split the transformers into passes, composing runs of composable
+     * transformers, and calculate the bounding box after each pass. */
+    std::vector<transform_pass_t> passes;
+    wf::geometry_t bbox = obox;
+    view_impl->transforms.for_each([&] (auto& block)
+    {
+        glm::mat4 transform{1.0};
+        glm::vec4 color{1.0};
+        bool composable =
+            block->transform->get_affine_transform(bbox, transform, color);
+        if (!composable || passes.empty() || !passes.back().composed)
+        {
+            passes.emplace_back();
+            passes.back().composed  = composable;
+            passes.back().input_box = bbox;
+        }
 
-    /* final_transform is the one that should render to the screen */
-    std::shared_ptr<view_transform_block_t> final_transform = nullptr;
+        auto& pass = passes.back();
+        pass.blocks.push_back(block);
+        pass.transform = transform * pass.transform;
+        pass.color    *= color;
 
-    /* Render the view passing its snapshot through the transformers.
-     * For each transformer except the last we render on offscreen buffers,
-     * and the last one is rendered to the real fb. */
-    auto& transforms = view_impl->transforms;
-    transforms.for_each([&] (auto& transform) -> void
+        bbox = block->transform->get_bounding_box(bbox, bbox);
+        pass.output_box = bbox;
+    });
+
+    /* When the view is shrunk a lot, sample a downscaled snapshot instead,
+     * which is cheaper and aliases less. 2D transformers which are not
+     * composable (e.g. scale's) still sample their input over its bounding
+     * box, so their scale can be used as well. */
+    float scale_x = 1.0, scale_y = 1.0;
+    if (!passes.empty() && passes.front().composed)
+    {
+        auto& transform = passes.front().transform;
+        scale_x = glm::length(glm::vec2(transform[0]));
+        scale_y = glm::length(glm::vec2(transform[1]));
+    } else if (!passes.empty())
     {
-        /* Last transform is handled separately */
-        if (transform == transforms.back())
+        auto tr = passes.front().blocks.front()->transform.get();
+        if (auto tr_2d = dynamic_cast<wf::view_2D*>(tr))
         {
-            final_transform = transform;
+            scale_x = std::abs(tr_2d->scale_x);
+            scale_y = std::abs(tr_2d->scale_y);
+        }
+    }
 
-            return;
+    if ((scale_x <= 0.5) && (scale_y <= 0.5))
+    {
+        auto& lod = take_lod_snapshot(
+            std::ceil(obox.width * scale_x * framebuffer.scale),
+            std::ceil(obox.height * scale_y * framebuffer.scale));
+        previous_texture = wf::texture_t{lod.tex};
+    }
+
+    /* Only the output of the last transformer of each pass except the last
+     * is cached, the buffers of the other transformers are not needed. */
+    auto release_unused_buffers = [] (transform_pass_t& pass, bool keep_last)
+    {
+        for (size_t i = 0; i < pass.blocks.size(); i++)
+        {
+            auto& block = pass.blocks[i];
+            if ((i + 1 == pass.blocks.size()) && keep_last)
+            {
+                continue;
+            }
+
+            block->cached_damage.clear();
+            block->damage_all = true;
+            if (block->fb.fb != (uint32_t)-1)
+            {
+                OpenGL::render_begin();
+                block->fb.release();
+                OpenGL::render_end();
+            }
         }
+    };
+
+    /* The parts of the previous pass's output which were rendered again, i.e
+     * the damage of the input of the next pass */
+    wf::region_t carried_damage;
 
-        /* Calculate size after this transform */
-        auto transformed_box =
-            transform->transform->get_bounding_box(obox, obox);
+    /* Render the view passing its snapshot through the transformers.
+     * For each pass except the last we render on offscreen buffers,
+     * and the last one is rendered to the real fb.
+     *
+     * The passes keep shared_ptrs to the transform blocks, so that even if
+     * a transformer gets removed while rendering, its texture remains
+     * valid. */
+    for (size_t i = 0; i + 1 < passes.size(); i++)
+    {
+        auto& pass  = passes[i];
+        auto& block = pass.blocks.back();
+
+        /* Collect the damage of the input of the pass */
+        carried_damage |= pass.blocks.front()->cached_damage;
+        bool damage_all = false;
+        for (auto& b : pass.blocks)
+        {
+            damage_all |= b->damage_all;
+        }
+
+        /* The parameters of composed transformers are fully described by
+         * the composed transform, so changes can be detected here. Other
+         * transformers are only cached if they damage the view themselves. */
+        if (pass.composed)
+        {
+            damage_all |= (block->cached_transform != pass.transform) ||
+                (block->cached_color != pass.color);
+            block->cached_transform = pass.transform;
+            block->cached_color     = pass.color;
+        } else
+        {
+            damage_all |= !block->transform->is_output_cacheable();
+        }
+
+        release_unused_buffers(pass, true);
+
+        /* Calculate size after this pass */
+        auto transformed_box = pass.output_box;
         int scaled_width  = transformed_box.width * texture_scale;
         int scaled_height = transformed_box.height * texture_scale;
 
-        /* Prepare buffer to store result after the transform */
+        /* Prepare buffer to store result after the pass */
         OpenGL::render_begin();
-        transform->fb.allocate(scaled_width, scaled_height);
-        transform->fb.scale    = texture_scale;
-        transform->fb.geometry = transformed_box;
-        transform->fb.bind(); // bind buffer to clear it
-        OpenGL::clear({0, 0, 0, 0});
-        OpenGL::render_end();
+        if (block->fb.allocate(scaled_width, scaled_height) ||
+            (block->fb.scale != texture_scale) ||
+            (block->fb.geometry != transformed_box))
+        {
+            damage_all = true;
+        }
 
-        /* Actually render the transform to the next framebuffer */
-        transform->transform->render_with_damage(previous_texture, obox,
-            wf::region_t{transformed_box}, transform->fb);
+        block->fb.scale    = texture_scale;
+        block->fb.geometry = transformed_box;
 
-        previous_transform = transform;
-        previous_texture   = previous_transform->fb.tex;
-        obox = transformed_box;
-    });
+        /* Only the parts of the buffer affected by the changed input have to
+         * be rendered again */
+        wf::region_t fb_damage;
+        if (damage_all)
+        {
+            fb_damage = transformed_box;
+        } else
+        {
+            for (auto& rect : carried_damage & pass.input_box)
+            {
+                /* Filtering may spread changes to neighbouring pixels */
+                auto box = pass.get_bounding_box(wlr_box_from_pixman_box(rect));
+                fb_damage |= wf::geometry_t{box.x - 1, box.y - 1,
+                    box.width + 2, box.height + 2};
+            }
 
-    /* This can happen in two ways:
-     * 1. The view is unmapped, and no snapshot
-     * 2. The last transform was deleted while iterating, so now the last
-     *    transform is invalid in the list
-     *
-     * In both cases, we simply render whatever contents we have to the
-     * framebuffer. */
-    if (final_transform == nullptr)
-    {
-        OpenGL::render_begin(framebuffer);
-        auto matrix = framebuffer.get_orthographic_projection();
-        gl_geometry src_geometry = {
-            1.0f * obox.x, 1.0f * obox.y,
-            1.0f * obox.x + 1.0f * obox.width,
-            1.0f * obox.y + 1.0f * obox.height,
-        };
+            fb_damage &= transformed_box;
+        }
+
+        block->cached_damage.clear();
+        block->damage_all = false;
 
-        for (const auto& rect : damage)
+        block->fb.bind(); // bind buffer to clear it
+        for (auto& rect : fb_damage)
         {
-            framebuffer.logic_scissor(wlr_box_from_pixman_box(rect));
-            OpenGL::render_transformed_texture(previous_texture, src_geometry,
-                {}, matrix);
+            block->fb.logic_scissor(wlr_box_from_pixman_box(rect));
+            OpenGL::clear({0, 0, 0, 0});
         }
 
         OpenGL::render_end();
+
+        /* Actually render the pass to the next framebuffer */
+        if (!fb_damage.empty())
+        {
+            pass.render(previous_texture, fb_damage, block->fb);
+        }
+
+        previous_texture = block->fb.tex;
+        carried_damage   = std::move(fb_damage);
+    }
+
+    if (passes.empty())
+    {
+        /* The view is unmapped and has no transformers, simply render its
+         * snapshot to the framebuffer. */
+        OpenGL::render_begin(framebuffer);
+        OpenGL::render_texture(previous_texture, framebuffer, obox, damage);
+        OpenGL::render_end();
     } else
     {
-        /* Regular case, just call the last transformer, but render directly
-         * to the target framebuffer */
-        final_transform->transform->render_with_damage(previous_texture, obox,
-            damage & framebuffer.geometry, framebuffer);
+        /* Regular case, just render the last pass directly to the target
+         * framebuffer */
+        release_unused_buffers(passes.back(), false);
+        passes.back().render(previous_texture, damage & framebuffer.geometry,
+            framebuffer);
     }
 
     return true;
@@ -1181,6 +1417,10 @@ const wf::framebuffer_t& wf::view_interface_t::take_snapshot()
     }
 
     auto& offscreen_buffer = view_impl->offscreen_buffer;
+    if (offscreen_buffer.owner.empty())
+    {
+        offscreen_buffer.owner = "view " + std::to_string(get_id()) + " snapshot";
+    }
 
     auto buffer_geometry = get_untransformed_bounding_box();
     offscreen_buffer.geometry = buffer_geometry;
@@ -1188,8 +1428,10 @@ const wf::framebuffer_t& wf::view_interface_t::take_snapshot()
     float scale = get_output()->handle->scale;
 
     offscreen_buffer.cached_damage &= buffer_geometry;
+    snapshot_cache_t::get().touch(this);
+
     /* Nothing has changed, the last buffer is still valid */
-    if (offscreen_buffer.cached_damage.empty())
+    if (offscreen_buffer.cached_damage.empty() && offscreen_buffer.valid())
     {
         return view_impl->offscreen_buffer;
     }
@@ -1215,7 +1457,9 @@ const wf::framebuffer_t& wf::view_interface_t::take_snapshot()
     OpenGL::render_end();
 
     auto output_geometry = get_output_geometry();
-    auto children = enumerate_surfaces({output_geometry.x, output_geometry.y});
+    auto& children = view_impl->snapshot_surfaces;
+    children.clear();
+    collect_surfaces(children, {output_geometry.x, output_geometry.y});
     for (auto& child : wf::reverse(children))
     {
         wlr_box child_box{
@@ -1225,7 +1469,7 @@ const wf::framebuffer_t& wf::view_interface_t::take_snapshot()
             child.surface->get_size().height
         };
 
-        child.surface->simple_render(offscreen_buffer,
+        wf::render_surface(child.surface, offscreen_buffer,
             child.position.x, child.position.y,
             offscreen_buffer.cached_damage & child_box);
     }
@@ -1235,6 +1479,105 @@ const wf::framebuffer_t& wf::view_interface_t::take_snapshot()
     return view_impl->offscreen_buffer;
 }
 
+/* The maximal number of downscaled snapshots of a view */
+static constexpr size_t MAX_LOD_LEVELS = 8;
+
+const wf::framebuffer_t& wf::view_interface_t::take_lod_snapshot(
+    int max_width, int max_height)
+{
+    auto& snapshot = take_snapshot();
+    if ((snapshot.viewport_width <= 0) || (snapshot.viewport_height <= 0))
+    {
+        return snapshot;
+    }
+
+    /* The size of the view when it is scaled to fit */
+    double factor = std::min(1.0,
+        std::min(1.0 * max_width / snapshot.viewport_width,
+            1.0 * max_height / snapshot.viewport_height));
+    int target_width  = std::max(1.0, std::ceil(snapshot.viewport_width * factor));
+    int target_height =
+        std::max(1.0, std::ceil(snapshot.viewport_height * factor));
+
+    size_t level = 0;
+    while ((level < MAX_LOD_LEVELS) &&
+           ((snapshot.viewport_width >> (level + 1)) >= target_width) &&
+           ((snapshot.viewport_height >> (level + 1)) >= target_height))
+    {
+        ++level;
+    }
+
+    /* Update each level from the previous one, the deeper levels are kept
+     * for later use with their pending damage */
+    auto& levels = view_impl->lod_snapshots;
+    const wf::framebuffer_t *source = &snapshot;
+    OpenGL::render_begin();
+    for (size_t i = 0; i < level; i++)
+    {
+        if (i == levels.size())
+        {
+            levels.push_back(
+                std::make_unique<view_priv_impl::offscreen_buffer_t>());
+            levels.back()->owner = "view " + std::to_string(get_id()) +
+                " snapshot LOD";
+        }
+
+        auto& lod = *levels[i];
+        if (lod.allocate(std::max(1, source->viewport_width / 2),
+            std::max(1, source->viewport_height / 2)) ||
+            (lod.geometry != source->geometry))
+        {
+            lod.cached_damage |= source->geometry;
+        }
+
+        lod.geometry = source->geometry;
+        lod.scale    = source->scale / 2;
+
+        /* Filtering reads the neighbouring pixels of the previous level */
+        int pad = std::ceil(1.0 / lod.scale);
+        wf::region_t damage;
+        for (auto& rect : lod.cached_damage & lod.geometry)
+        {
+            auto box = wlr_box_from_pixman_box(rect);
+            damage |= wf::geometry_t{box.x - pad, box.y - pad,
+                box.width + 2 * pad, box.height + 2 * pad};
+        }
+
+        damage &= lod.geometry;
+        lod.cached_damage.clear();
+        if (!damage.empty())
+        {
+            lod.bind();
+            for (auto& rect : damage)
+            {
+                lod.logic_scissor(wlr_box_from_pixman_box(rect));
+                OpenGL::clear({0, 0, 0, 0});
+            }
+
+            OpenGL::render_texture(wf::texture_t{source->tex}, lod,
+                lod.geometry, damage);
+        }
+
+        source = &lod;
+    }
+
+    OpenGL::render_end();
+
+    return *source;
+}
+
+void wf::view_interface_t::release_lod_snapshots()
+{
+    OpenGL::render_begin();
+    for (auto& lod : view_impl->lod_snapshots)
+    {
+        lod->release();
+    }
+
+    OpenGL::render_end();
+    view_impl->lod_snapshots.clear();
+}
+
 wf::view_interface_t::view_interface_t()
 {
     this->view_impl = std::make_unique<wf::view_interface_t::view_priv_impl>();
@@ -1275,6 +1618,8 @@ void wf::view_interface_t::deinitialize()
     OpenGL::render_begin();
     this->view_impl->offscreen_buffer.release();
     OpenGL::render_end();
+    release_lod_snapshots();
+    snapshot_cache_t::get().forget(this);
 }
 
 wf::view_interface_t::~view_interface_t()
@@ -1290,7 +1635,7 @@ void wf::view_interface_t::damage_surface_box(const wlr_box& box)
     auto damaged = box;
     damaged.x += obox.x;
     damaged.y += obox.y;
-    view_impl->offscreen_buffer.cached_damage |= damaged;
+    view_impl->cache_damage(damaged);
     view_damage_raw(self(), transform_region(damaged));
 }
 
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+
+/**
+ * Helpers shared by the benchmarks.
+ *
+ * Benchmarks are run with `meson test --benchmark`, or directly, in which
+ * case the number of repetitions can be given as the first argument.
+ */
+
+/**
+ * Get the number of repetitions from the command line.
+ *
+ * @param default_count The number of repetitions if none is given.
+ */
+inline int bench_get_count(int argc, char **argv, int default_count)
+{
+    return (argc > 1) ? std::atoi(argv[1]) : default_count;
+}
+
+/**
+ * Run the given function count times and print the average time per run.
+ *
+ * @param unit The unit printed after the time, in nanoseconds per run.
+ * @return The average time per run in nanoseconds.
+ */
+inline double measure(const std::string& name, int count,
+    const std::function<void()>& run, const std::string& unit = "ns")
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; i++)
+    {
+        run();
+    }
+
+    auto end  = std::chrono::steady_clock::now();
+    auto nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        end - start).count();
+
+    double per_run = (count > 0) ? 1.0 * nsec / count : 0.0;
+    std::cout << "  " << name << ": " << per_run << " " << unit << std::endl;
+    return per_run;
+}
@@ -0,0 +1,170 @@
+/*
+ * Replays typical damage patterns and reports how coalescing changes the
+ * number of rectangles, the repainted area and the time spent coalescing.
+ *
+ * Unlike the other benchmarks, it takes the pattern to replay (terminal,
+ * editor, scattered) as argument when run directly.
+ */
+#include <wayfire/region.hpp>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+#include "../bench.hpp"
+
+using damage_pattern_t = std::vector<wf::region_t>;
+
+/* A terminal which prints text: each frame, a few lines get some glyphs
+ * updated, each glyph cell is damaged separately. */
+static damage_pattern_t record_terminal(int frames)
+{
+    const int cell_w = 9, cell_h = 18;
+    std::mt19937 gen(1);
+
+    damage_pattern_t pattern;
+    for (int f = 0; f < frames; f++)
+    {
+        wf::region_t damage;
+        int lines = 1 + gen() % 4;
+        for (int l = 0; l < lines; l++)
+        {
+            int row = gen() % 50;
+            for (int col = 0; col < 200; col++)
+            {
+                if (gen() % 3 == 0)
+                {
+                    damage |= wf::geometry_t{col * cell_w, row * cell_h,
+                        cell_w - 1, cell_h - 2};
+                }
+            }
+        }
+
+        pattern.push_back(damage);
+    }
+
+    return pattern;
+}
+
+/* An editor with syntax highlighting, line numbers and a blinking cursor:
+ * short runs of text spread over the visible lines. */
+static damage_pattern_t record_editor(int frames)
+{
+    std::mt19937 gen(2);
+
+    damage_pattern_t pattern;
+    for (int f = 0; f < frames; f++)
+    {
+        wf::region_t damage;
+        damage |= wf::geometry_t{400 + (int)(gen() % 800), 300, 2, 20};
+        for (int line = 0; line < 60; line++)
+        {
+            damage |= wf::geometry_t{4, 40 + line * 17, 30, 15};
+            int x = 60;
+            while (x < 1800)
+            {
+                int len = 8 + gen() % 80;
+                if (gen() % 2)
+                {
+                    damage |= wf::geometry_t{x, 40 + line * 17, len, 15};
+                }
+
+                x += len + 8;
+            }
+        }
+
+        pattern.push_back(damage);
+    }
+
+    return pattern;
+}
+
+/* Many unrelated small updates all over the screen, e.g. several animated
+ * widgets and notifications. */
+static damage_pattern_t record_scattered(int frames)
+{
+    std::mt19937 gen(3);
+
+    damage_pattern_t pattern;
+    for (int f = 0; f < frames; f++)
+    {
+        wf::region_t damage;
+        for (int i = 0; i < 300; i++)
+        {
+            damage |= wf::geometry_t{(int)(gen() % 1900), (int)(gen() % 1060),
+                4 + (int)(gen() % 16), 4 + (int)(gen() % 16)};
+        }
+
+        pattern.push_back(damage);
+    }
+
+    return pattern;
+}
+
+static uint64_t get_area(const wf::region_t& region)
+{
+    uint64_t area = 0;
+    for (const auto& box : region)
+    {
+        area += uint64_t(box.x2 - box.x1) * (box.y2 - box.y1);
+    }
+
+    return area;
+}
+
+static void replay(const std::string& name, const damage_pattern_t& pattern)
+{
+    std::cout << name << ":" << std::endl;
+    const size_t thresholds[] = {0, 16, 32, 64, 128};
+    const double wastes[] = {0.1, 0.3, 0.5};
+
+    for (auto threshold : thresholds)
+    {
+        for (auto waste : wastes)
+        {
+            uint64_t rects = 0, area = 0, original_area = 0;
+            size_t frame   = 0;
+            std::ostringstream name;
+            name << "threshold " << threshold << " waste " << waste;
+            measure(name.str(), pattern.size(), [&] ()
+            {
+                auto damage = pattern[frame++];
+                original_area += get_area(damage);
+                damage.coalesce(threshold, waste);
+                rects += damage.end() - damage.begin();
+                area  += get_area(damage);
+            }, "ns/frame");
+
+            std::cout << "    " << rects / pattern.size() << " rects/frame, " <<
+                (100.0 * area / original_area) << "% area" << std::endl;
+
+            if (threshold == 0)
+            {
+                break;
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const int frames = 500;
+    const char *only = (argc > 1) ? argv[1] : nullptr;
+
+    if (!only || !strcmp(only, "terminal"))
+    {
+        replay("terminal", record_terminal(frames));
+    }
+
+    if (!only || !strcmp(only, "editor"))
+    {
+        replay("editor", record_editor(frames));
+    }
+
+    if (!only || !strcmp(only, "scattered"))
+    {
+        replay("scattered", record_scattered(frames));
+    }
+
+    return 0;
+}
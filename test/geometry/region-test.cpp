@@ -0,0 +1,88 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <wayfire/region.hpp>
+
+static size_t count_rects(const wf::region_t& region)
+{
+    return region.end() - region.begin();
+}
+
+static bool contains(const wf::region_t& big, const wf::region_t& small)
+{
+    return (small ^ big).empty();
+}
+
+/* A grid of size x size rectangles of 2x2 pixels, spaced 4 pixels apart */
+static wf::region_t make_checkerboard(int size)
+{
+    wf::region_t region;
+    for (int i = 0; i < size; i++)
+    {
+        for (int j = 0; j < size; j++)
+        {
+            region |= wf::geometry_t{i * 4, j * 4, 2, 2};
+        }
+    }
+
+    return region;
+}
+
+TEST_CASE("Coalescing keeps small regions")
+{
+    wf::region_t region = make_checkerboard(4);
+    wf::region_t original = region;
+
+    region.coalesce(16, 1.0);
+    REQUIRE(count_rects(region) == 16);
+    REQUIRE((region ^ original).empty());
+    REQUIRE((original ^ region).empty());
+
+    region.coalesce(0, 1.0);
+    REQUIRE(count_rects(region) == 16);
+}
+
+TEST_CASE("Coalescing reduces the number of rectangles")
+{
+    wf::region_t region = make_checkerboard(32);
+    wf::region_t original = region;
+    REQUIRE(count_rects(region) == 32 * 32);
+
+    region.coalesce(16, 1.0);
+    REQUIRE(count_rects(region) <= 16);
+    REQUIRE(contains(region, original));
+}
+
+TEST_CASE("Coalescing respects the waste limit")
+{
+    wf::region_t region = make_checkerboard(32);
+    wf::region_t original = region;
+
+    /* The checkerboard covers a quarter of the area, any coalescing
+     * wastes at least half of it. */
+    region.coalesce(16, 0.5);
+    REQUIRE(count_rects(region) == 32 * 32);
+    REQUIRE((region ^ original).empty());
+
+    region.coalesce(16, 0.8);
+    REQUIRE(count_rects(region) < 32 * 32);
+    REQUIRE(contains(region, original));
+
+    auto extents = region.get_extents();
+    REQUIRE(extents.x1 == 0);
+    REQUIRE(extents.y1 == 0);
+}
+
+TEST_CASE("Coalescing with negative coordinates")
+{
+    wf::region_t region;
+    for (int i = 0; i < 64; i++)
+    {
+        region |= wf::geometry_t{-1000 + i * 3, -500, 1, 10};
+    }
+
+    wf::region_t original = region;
+    region.coalesce(4, 1.0);
+    REQUIRE(count_rects(region) <= 4);
+    REQUIRE(contains(region, original));
+}
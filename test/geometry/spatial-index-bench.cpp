@@ -0,0 +1,90 @@
+/*
+ * Compares finding the views on each workspace of a 5x5 workspace grid with
+ * a linear scan of all views and with spatial_index_t, for 10, 100 and 1000
+ * views, as well as the cost of keeping the index up to date when views move.
+ */
+#include "output/spatial-index.hpp"
+#include <iostream>
+#include <random>
+#include <vector>
+#include "../bench.hpp"
+
+static const wf::dimensions_t screen = {1920, 1080};
+static const wf::dimensions_t grid   = {5, 5};
+
+static wf::geometry_t random_view(std::mt19937& gen)
+{
+    int ws_x = gen() % grid.width, ws_y = gen() % grid.height;
+    return {ws_x * screen.width + (int)(gen() % 1600) - 100,
+        ws_y * screen.height + (int)(gen() % 900) - 100,
+        200 + (int)(gen() % 1200), 150 + (int)(gen() % 700)};
+}
+
+static void bench(int count, int nr_views)
+{
+    std::mt19937 gen(1);
+    std::vector<wf::geometry_t> views;
+    wf::spatial_index_t<int> index{screen};
+    for (int i = 0; i < nr_views; i++)
+    {
+        views.push_back(random_view(gen));
+        index.update(i, views.back());
+    }
+
+    std::cout << nr_views << " views:" << std::endl;
+
+    size_t found = 0;
+    measure("views on all workspaces, linear scan", count, [&] ()
+    {
+        for (int x = 0; x < grid.width; x++)
+        {
+            for (int y = 0; y < grid.height; y++)
+            {
+                wf::geometry_t ws = {x * screen.width, y * screen.height,
+                    screen.width, screen.height};
+                for (auto& view : views)
+                {
+                    found += (view & ws);
+                }
+            }
+        }
+    });
+
+    measure("views on all workspaces, spatial index", count, [&] ()
+    {
+        for (int x = 0; x < grid.width; x++)
+        {
+            for (int y = 0; y < grid.height; y++)
+            {
+                wf::geometry_t ws = {x * screen.width, y * screen.height,
+                    screen.width, screen.height};
+                index.for_each_intersecting(ws, [&] (int) { found++; });
+            }
+        }
+    });
+
+    measure("move a view", count, [&] ()
+    {
+        int view = gen() % nr_views;
+        views[view] = views[view] + wf::point_t{(int)(gen() % 41) - 20,
+            (int)(gen() % 41) - 20};
+        index.update(view, views[view]);
+    });
+
+    /* Keep the compiler from dropping the queries */
+    if (found == 0)
+    {
+        std::cout << "  no views found" << std::endl;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int count = bench_get_count(argc, argv, 10000);
+    for (int views : {10, 100, 1000})
+    {
+        bench(count, views);
+    }
+
+    return 0;
+}
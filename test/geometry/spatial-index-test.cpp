@@ -0,0 +1,126 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "output/spatial-index.hpp"
+#include <algorithm>
+#include <random>
+#include <set>
+#include <vector>
+
+static std::set<int> query(wf::spatial_index_t<int>& index, wf::geometry_t area)
+{
+    std::set<int> result;
+    index.for_each_intersecting(area, [&] (int key)
+    {
+        REQUIRE(!result.count(key));
+        result.insert(key);
+    });
+
+    return result;
+}
+
+TEST_CASE("Spatial index finds intersecting boxes")
+{
+    wf::spatial_index_t<int> index{{100, 100}};
+    index.update(1, {10, 10, 50, 50});
+    index.update(2, {90, 90, 20, 20});
+    index.update(3, {-150, -20, 40, 40});
+
+    REQUIRE(index.size() == 3);
+    REQUIRE(query(index, {0, 0, 100, 100}) == std::set<int>{1, 2});
+    REQUIRE(query(index, {100, 100, 5, 5}) == std::set<int>{2});
+    REQUIRE(query(index, {-200, -200, 100, 400}) == std::set<int>{3});
+    REQUIRE(query(index, {500, 500, 10, 10}).empty());
+
+    index.update(1, {300, 300, 10, 10});
+    REQUIRE(query(index, {0, 0, 100, 100}) == std::set<int>{2});
+    REQUIRE(query(index, {250, 250, 100, 100}) == std::set<int>{1});
+
+    index.remove(2);
+    REQUIRE(!index.contains(2));
+    REQUIRE(query(index, {0, 0, 100, 100}).empty());
+}
+
+TEST_CASE("Spatial index matches a linear scan")
+{
+    std::mt19937 gen(1);
+    auto random_box = [&] (int max_size)
+    {
+        return wf::geometry_t{(int)(gen() % 6000) - 1000,
+            (int)(gen() % 4000) - 1000,
+            (int)(gen() % max_size), (int)(gen() % max_size)};
+    };
+
+    wf::spatial_index_t<int> index{{1920, 1080}};
+    std::vector<wf::geometry_t> boxes;
+    for (int i = 0; i < 200; i++)
+    {
+        /* A few huge boxes which span many cells */
+        boxes.push_back(random_box(i % 50 ? 1500 : 100000));
+        index.update(i, boxes.back());
+    }
+
+    for (int round = 0; round < 200; round++)
+    {
+        int moved = gen() % boxes.size();
+        boxes[moved] = random_box(1500);
+        index.update(moved, boxes[moved]);
+        if (round == 100)
+        {
+            index.set_cell_size({500, 700});
+        }
+
+        auto area = random_box(3000);
+        std::set<int> expected;
+        for (size_t i = 0; i < boxes.size(); i++)
+        {
+            if (boxes[i] & area)
+            {
+                expected.insert(i);
+            }
+        }
+
+        REQUIRE(query(index, area) == expected);
+    }
+}
+
+TEST_CASE("Workspace index keeps boxes relative to the current workspace")
+{
+    auto query_ws = [] (wf::workspace_index_t<int>& index, wf::geometry_t area)
+    {
+        std::set<int> result;
+        index.for_each_intersecting(area, [&] (int key) { result.insert(key); });
+        return result;
+    };
+
+    const wf::geometry_t current = {0, 0, 1000, 500};
+    const wf::geometry_t right   = {1000, 0, 1000, 500};
+
+    wf::workspace_index_t<int> index{{1000, 500}};
+    index.update(1, {100, 100, 200, 200});
+    index.update(2, {100, 100, 200, 200});
+    index.update(3, {1100, 100, 200, 200});
+    REQUIRE(query_ws(index, current) == std::set<int>{1, 2});
+    REQUIRE(query_ws(index, right) == std::set<int>{3});
+
+    /* Switch to the workspace on the right. View 1 is moved along with the
+     * workspace, like regular views. Views 2 and 3 are not moved, like fixed
+     * views or views outside of the middle layers, so they keep their
+     * position relative to the current workspace. */
+    index.set_current_workspace({1, 0});
+    index.update(1, {-900, 100, 200, 200});
+
+    const wf::geometry_t left = {-1000, 0, 1000, 500};
+    REQUIRE(query_ws(index, left) == std::set<int>{1});
+    REQUIRE(query_ws(index, current) == std::set<int>{2});
+    REQUIRE(query_ws(index, right) == std::set<int>{3});
+
+    /* A different screen size keeps the relative boxes */
+    index.set_screen_size({500, 500});
+    REQUIRE(query_ws(index, {0, 0, 500, 500}) == std::set<int>{2});
+    REQUIRE(query_ws(index, {-1000, 0, 500, 500}) == std::set<int>{1});
+
+    index.remove(2);
+    REQUIRE(!index.contains(2));
+    REQUIRE(query_ws(index, {0, 0, 500, 500}).empty());
+}
@@ -0,0 +1,70 @@
+/*
+ * Compares safe_list_t with safe_vector_t for the typical uses of them in
+ * the core: iterating lists of signal connections or effect hooks, and
+ * connecting/disconnecting their elements.
+ */
+#include <wayfire/nonstd/safe-list.hpp>
+#include <wayfire/nonstd/safe-vector.hpp>
+#include <iostream>
+#include <string>
+#include "../bench.hpp"
+#include "../mock.hpp"
+
+template<class List>
+static void bench(const std::string& name, int count, size_t elements)
+{
+    List list;
+    for (size_t i = 0; i < elements; i++)
+    {
+        list.push_back((int*)(i + 1));
+    }
+
+    std::cout << name << " with " << elements << " elements:" << std::endl;
+
+    uintptr_t sum = 0;
+    measure("for_each", count, [&] ()
+    {
+        list.for_each([&] (int *el) { sum += (uintptr_t)el; });
+    });
+
+    int *extra = (int*)(elements + 1);
+    measure("push_back + remove_all", count, [&] ()
+    {
+        list.push_back(extra);
+        list.remove_all(extra);
+        mock_loop::get().dispatch_idle();
+    });
+
+    measure("remove_all while iterating", count, [&] ()
+    {
+        list.push_back(extra);
+        list.for_each([&] (int *el)
+        {
+            if (el == extra)
+            {
+                list.remove_all(extra);
+            }
+        });
+        mock_loop::get().dispatch_idle();
+    });
+
+    /* Keep the sum alive */
+    if (sum == 1)
+    {
+        std::cout << sum << std::endl;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const int count = bench_get_count(argc, argv, 100000);
+    mock_loop::get().start(0);
+
+    for (size_t elements : {1, 10, 100})
+    {
+        bench<wf::safe_list_t<int*>>("safe_list_t", count, elements);
+        bench<wf::safe_vector_t<int*>>("safe_vector_t", count, elements);
+    }
+
+    return 0;
+}
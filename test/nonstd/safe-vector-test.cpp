@@ -0,0 +1,154 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <wayfire/nonstd/safe-vector.hpp>
+#include <memory>
+
+using list_t = wf::safe_vector_t<int>;
+
+static std::vector<int> collect(const list_t& list)
+{
+    std::vector<int> result;
+    list.for_each([&] (int& el) { result.push_back(el); });
+    return result;
+}
+
+TEST_CASE("Basic operations")
+{
+    list_t list;
+    list.push_back(1);
+    list.push_back(2);
+    list.push_back(3);
+    REQUIRE(list.size() == 3);
+    REQUIRE(list.back() == 3);
+
+    list.remove_all(2);
+    REQUIRE(list.size() == 2);
+    REQUIRE(collect(list) == std::vector<int>{1, 3});
+
+    list.emplace_at(2, [] (int& el)
+    {
+        return (el == 3) ? list_t::INSERT_BEFORE : list_t::INSERT_NONE;
+    });
+    REQUIRE(collect(list) == std::vector<int>{1, 2, 3});
+
+    std::vector<int> reversed;
+    list.for_each_reverse([&] (int& el) { reversed.push_back(el); });
+    REQUIRE(reversed == std::vector<int>{3, 2, 1});
+
+    list.clear();
+    REQUIRE(list.size() == 0);
+    REQUIRE_THROWS(list.back());
+}
+
+TEST_CASE("Adding elements while iterating")
+{
+    list_t list;
+    list.push_back(1);
+    list.push_back(3);
+
+    std::vector<int> visited;
+    list.for_each([&] (int& el)
+    {
+        visited.push_back(el);
+        if (el == 1)
+        {
+            /* Not visited by the current iteration */
+            list.push_back(4);
+            list.emplace_at(2, [] (int& other)
+            {
+                return (other == 3) ? list_t::INSERT_BEFORE :
+                       list_t::INSERT_NONE;
+            });
+
+            REQUIRE(list.size() == 4);
+            REQUIRE(list.back() == 4);
+
+            /* Nested iterations visit them after the other elements */
+            REQUIRE(collect(list) == std::vector<int>{1, 3, 4, 2});
+        }
+    });
+
+    REQUIRE(visited == std::vector<int>{1, 3});
+    /* The order is restored at the safe point */
+    REQUIRE(collect(list) == std::vector<int>{1, 2, 3, 4});
+}
+
+TEST_CASE("Removing elements while iterating")
+{
+    list_t list;
+    for (int i = 0; i < 5; i++)
+    {
+        list.push_back(i);
+    }
+
+    auto generation = list.get_generation();
+    std::vector<int> visited;
+    list.for_each([&] (int& el)
+    {
+        visited.push_back(el);
+        if (el == 1)
+        {
+            list.remove_all(1);
+            list.remove_all(3);
+            REQUIRE(list.size() == 3);
+
+            /* Elements do not move while the list is iterated */
+            REQUIRE(list.get_generation() == generation);
+        }
+
+        if (el == 2)
+        {
+            /* Added and removed in the same iteration */
+            list.push_back(5);
+            list.remove_all(5);
+        }
+    });
+
+    REQUIRE(visited == std::vector<int>{0, 1, 2, 4});
+    REQUIRE(list.get_generation() > generation);
+    REQUIRE(list.size() == 3);
+    REQUIRE(collect(list) == std::vector<int>{0, 2, 4});
+}
+
+TEST_CASE("Removed elements are destroyed immediately")
+{
+    wf::safe_vector_t<std::shared_ptr<int>> list;
+    auto a = std::make_shared<int>(1);
+    auto b = std::make_shared<int>(2);
+    list.push_back(a);
+    list.push_back(b);
+
+    list.for_each([&] (std::shared_ptr<int>& el)
+    {
+        if (el == a)
+        {
+            list.remove_all(b);
+            REQUIRE(b.use_count() == 1);
+        }
+    });
+
+    REQUIRE(list.size() == 1);
+    REQUIRE(list.back() == a);
+}
+
+TEST_CASE("Nested iteration with removal")
+{
+    list_t list;
+    list.push_back(1);
+    list.push_back(2);
+
+    int visits = 0;
+    list.for_each([&] (int&)
+    {
+        list.for_each([&] (int& inner)
+        {
+            ++visits;
+            list.remove_all(inner);
+        });
+    });
+
+    /* The outer iteration does not visit removed elements */
+    REQUIRE(visits == 2);
+    REQUIRE(list.size() == 0);
+}
@@ -0,0 +1,89 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <wayfire/object.hpp>
+#include "../mock.hpp"
+
+namespace
+{
+struct object_t : public wf::object_base_t
+{};
+
+struct data_a_t : public wf::custom_data_t
+{
+    int value = 1;
+};
+
+struct data_b_t : public wf::custom_data_t
+{
+    int value = 2;
+};
+
+struct data_late_t : public wf::custom_data_t
+{
+    int value = 3;
+};
+}
+
+TEST_CASE("Data stored by type is found by type and by name")
+{
+    object_t object;
+    REQUIRE(!object.has_data<data_a_t>());
+
+    object.get_data_safe<data_a_t>()->value = 5;
+    REQUIRE(object.has_data<data_a_t>());
+    REQUIRE(!object.has_data<data_b_t>());
+    REQUIRE(object.get_data<data_a_t>()->value == 5);
+    REQUIRE(object.get_data<data_a_t>(typeid(data_a_t).name())->value == 5);
+
+    object.erase_data(typeid(data_a_t).name());
+    REQUIRE(!object.has_data<data_a_t>());
+}
+
+TEST_CASE("Data stored by name is kept apart from data stored by type")
+{
+    object_t object;
+    object.store_data(std::make_unique<data_a_t>(), "custom");
+    object.store_data(std::make_unique<data_b_t>());
+
+    REQUIRE(object.has_data("custom"));
+    REQUIRE(!object.has_data<data_a_t>());
+    REQUIRE(object.get_data<data_b_t>()->value == 2);
+
+    auto released = object.release_data<data_a_t>("custom");
+    REQUIRE(released);
+    REQUIRE(!object.has_data("custom"));
+
+    auto released_b = object.release_data<data_b_t>();
+    REQUIRE(released_b->value == 2);
+    REQUIRE(!object.has_data<data_b_t>());
+}
+
+TEST_CASE("Data stored by name before the slot exists is found by type")
+{
+    object_t object;
+    object.store_data(std::make_unique<data_late_t>(),
+        typeid(data_late_t).name());
+    REQUIRE(object.get_data<data_late_t>()->value == 3);
+    REQUIRE(object.has_data(typeid(data_late_t).name()));
+}
+
+TEST_CASE("Data stored by name is moved to slots registered after a lookup")
+{
+    struct data_later_t : public wf::custom_data_t
+    {
+        int value = 4;
+    };
+
+    object_t object;
+    object.store_data(std::make_unique<data_a_t>(), "custom");
+    object.store_data(std::make_unique<data_later_t>(),
+        typeid(data_later_t).name());
+
+    /* A typed miss while the slot of data_later_t is not registered yet */
+    REQUIRE(!object.has_data<data_a_t>());
+
+    REQUIRE(object.get_data<data_later_t>()->value == 4);
+    REQUIRE(object.get_data<data_a_t>("custom")->value == 1);
+    REQUIRE(!object.has_data<data_a_t>());
+}
@@ -0,0 +1,96 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "output/layer-manager.hpp"
+#include <memory>
+#include <vector>
+
+namespace
+{
+/** A mapped view without contents and without an output */
+class mock_view_t : public wf::view_interface_t
+{
+  public:
+    wf::geometry_t geometry = {0, 0, 100, 100};
+
+    void move(int x, int y) override
+    {
+        geometry.x = x;
+        geometry.y = y;
+    }
+
+    wf::geometry_t get_output_geometry() override
+    {
+        return geometry;
+    }
+
+    wlr_surface *get_keyboard_focus_surface() override
+    {
+        return nullptr;
+    }
+
+    bool is_mapped() const override
+    {
+        return true;
+    }
+
+    wf::dimensions_t get_size() const override
+    {
+        return {geometry.width, geometry.height};
+    }
+
+    void simple_render(const wf::framebuffer_t&, int, int,
+        const wf::region_t&) override
+    {}
+};
+}
+
+TEST_CASE("The stack generation changes with each mutation of the layers")
+{
+    wf::output_layer_manager_t layers;
+    mock_view_t view_a, view_b;
+    wayfire_view a = view_a.self(), b = view_b.self();
+
+    /* Check that func changes the generation */
+    uint64_t generation = layers.get_stack_generation();
+    auto require_bump = [&] (auto func)
+    {
+        func();
+        REQUIRE(layers.get_stack_generation() != generation);
+        generation = layers.get_stack_generation();
+    };
+
+    /* Add */
+    require_bump([&] { layers.add_view_to_layer(a, wf::LAYER_WORKSPACE); });
+    require_bump([&] { layers.add_view_to_layer(b, wf::LAYER_WORKSPACE); });
+    REQUIRE(layers.get_views_in_layer(wf::LAYER_WORKSPACE) ==
+        std::vector<wayfire_view>{b, a});
+
+    /* Restack */
+    require_bump([&] { layers.restack_above(a, b); });
+    REQUIRE(layers.get_views_in_layer(wf::LAYER_WORKSPACE) ==
+        std::vector<wayfire_view>{a, b});
+    require_bump([&] { layers.restack_below(a, b); });
+    require_bump([&] { layers.bring_to_front(a); });
+    REQUIRE(layers.get_views_in_layer(wf::LAYER_WORKSPACE) ==
+        std::vector<wayfire_view>{a, b});
+
+    /* Move to another layer */
+    require_bump([&] { layers.add_view_to_layer(b, wf::LAYER_TOP); });
+    REQUIRE(layers.get_view_layer(b) == wf::LAYER_TOP);
+
+    /* Views moving and workspace changes are reported by the viewport
+     * manager, without changing the stack order */
+    auto snapshot = layers.get_views_in_layer(wf::ALL_LAYERS);
+    require_bump([&] { layers.views_moved(); });
+    REQUIRE(layers.get_views_in_layer(wf::ALL_LAYERS) == snapshot);
+
+    /* Remove */
+    require_bump([&] { layers.remove_view(a); });
+    require_bump([&] { layers.remove_view(b); });
+    REQUIRE(layers.get_views_in_layer(wf::ALL_LAYERS).empty());
+
+    /* Queries do not change the generation */
+    layers.get_views_in_layer(wf::ALL_LAYERS);
+    REQUIRE(layers.get_stack_generation() == generation);
+}
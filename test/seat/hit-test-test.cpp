@@ -0,0 +1,100 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "core/seat/hit-test.hpp"
+#include "view/surface-impl.hpp"
+#include "../view/mock-surface.hpp"
+#include <vector>
+
+using entry_t = wf::hit_test_cache_t::entry_t;
+
+namespace
+{
+/** A surface which accepts input only in its input region */
+class input_surface_t : public mock_surface_t
+{
+  public:
+    wf::region_t input_region;
+
+    input_surface_t(wf::region_t input_region) : input_region(input_region)
+    {}
+
+    bool accepts_input(int32_t sx, int32_t sy) override
+    {
+        return input_region.contains_point({sx, sy});
+    }
+};
+}
+
+TEST_CASE("The topmost surface accepting input at the point is found")
+{
+    input_surface_t top{wf::geometry_t{0, 0, 50, 50}};
+    input_surface_t bottom{wf::geometry_t{0, 0, 100, 100}};
+    std::vector<entry_t> entries = {
+        {nullptr, &top, {100, 100, 100, 100}},
+        {nullptr, &bottom, {100, 100, 100, 100}},
+    };
+
+    wf::pointf_t local;
+    REQUIRE(wf::hit_test_cache_t::find_surface(entries, {110, 120}, local) ==
+        &top);
+    REQUIRE(local.x == 10);
+    REQUIRE(local.y == 20);
+
+    /* Outside of the input region of the topmost surface */
+    REQUIRE(wf::hit_test_cache_t::find_surface(entries, {175, 160}, local) ==
+        &bottom);
+    REQUIRE(local.x == 75);
+    REQUIRE(local.y == 60);
+}
+
+TEST_CASE("Points outside of all surfaces miss")
+{
+    /* The input region is larger than the surface */
+    input_surface_t surface{wf::geometry_t{-50, -50, 200, 200}};
+    std::vector<entry_t> entries = {
+        {nullptr, &surface, {100, 100, 100, 100}},
+    };
+
+    wf::pointf_t local;
+    REQUIRE(!wf::hit_test_cache_t::find_surface(entries, {99, 150}, local));
+    REQUIRE(!wf::hit_test_cache_t::find_surface(entries, {200, 150}, local));
+    REQUIRE(!wf::hit_test_cache_t::find_surface({}, {150, 150}, local));
+}
+
+TEST_CASE("Only commits changing sizes or subsurface positions invalidate")
+{
+    auto& serial = wf::surface_interface_t::impl::input_serial;
+
+    mock_surface_t root;
+    auto child = root.add_child({10, 10});
+    wf::update_input_serial(&root);
+
+    /* A commit which only changes the contents */
+    auto last = serial;
+    wf::update_input_serial(&root);
+    REQUIRE(serial == last);
+
+    /* The surface is resized */
+    root.size = {200, 100};
+    wf::update_input_serial(&root);
+    REQUIRE(serial != last);
+
+    last = serial;
+    wf::update_input_serial(&root);
+    REQUIRE(serial == last);
+
+    /* A subsurface is moved, which is applied by the commit of its parent */
+    child->offset = {20, 10};
+    wf::update_input_serial(&root);
+    REQUIRE(serial != last);
+
+    last = serial;
+    wf::update_input_serial(child);
+    wf::update_input_serial(&root);
+    REQUIRE(serial == last);
+
+    /* Adding a subsurface invalidates directly */
+    root.add_child({0, 0});
+    REQUIRE(serial != last);
+}
@@ -0,0 +1,121 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "core/seat/motion-coalescer.hpp"
+
+static wf::pointer_motion_t motion(const void *device, uint32_t time,
+    double dx, double dy)
+{
+    return {device, time, dx, dy, dx / 2, dy / 2};
+}
+
+TEST_CASE("The first motion is processed right away")
+{
+    wf::motion_coalescer_t coalescer;
+    int device = 0;
+
+    auto now = coalescer.add(motion(&device, 1, 1, 2));
+    REQUIRE(now);
+    REQUIRE(now->time_msec == 1);
+    REQUIRE(now->delta_x == 1);
+    REQUIRE(now->delta_y == 2);
+    REQUIRE(coalescer.is_waiting_frame());
+    REQUIRE(!coalescer.take());
+}
+
+TEST_CASE("Motion until the frame is accumulated")
+{
+    wf::motion_coalescer_t coalescer;
+    int device = 0;
+
+    REQUIRE(coalescer.add(motion(&device, 1, 1, 1)));
+    REQUIRE(!coalescer.add(motion(&device, 2, 1, 2)));
+    REQUIRE(!coalescer.add(motion(&device, 3, 2, -4)));
+    REQUIRE(!coalescer.add(motion(&device, 4, 0.5, 0)));
+
+    auto flushed = coalescer.frame();
+    REQUIRE(flushed);
+    REQUIRE(flushed->device == &device);
+    REQUIRE(flushed->time_msec == 4);
+    REQUIRE(flushed->delta_x == 3.5);
+    REQUIRE(flushed->delta_y == -2);
+    REQUIRE(flushed->unaccel_dx == 1.75);
+    REQUIRE(flushed->unaccel_dy == -1);
+
+    REQUIRE(coalescer.get_stats().received == 4);
+    REQUIRE(coalescer.get_stats().folded == 2);
+
+    /* Still waiting, the motion keeps going */
+    REQUIRE(coalescer.is_waiting_frame());
+    REQUIRE(!coalescer.add(motion(&device, 5, 1, 1)));
+    flushed = coalescer.frame();
+    REQUIRE(flushed);
+    REQUIRE(flushed->time_msec == 5);
+    REQUIRE(flushed->delta_x == 1);
+}
+
+TEST_CASE("A frame without motion ends the waiting")
+{
+    wf::motion_coalescer_t coalescer;
+    int device = 0;
+
+    REQUIRE(coalescer.add(motion(&device, 1, 1, 1)));
+    REQUIRE(!coalescer.frame());
+    REQUIRE(!coalescer.is_waiting_frame());
+
+    /* The next motion is processed right away again */
+    REQUIRE(coalescer.add(motion(&device, 2, 1, 1)));
+    REQUIRE(coalescer.get_stats().folded == 0);
+}
+
+TEST_CASE("Pending motion can be flushed before the frame")
+{
+    wf::motion_coalescer_t coalescer;
+    int device = 0;
+
+    coalescer.add(motion(&device, 1, 1, 1));
+    coalescer.add(motion(&device, 2, 3, 3));
+
+    auto flushed = coalescer.take();
+    REQUIRE(flushed);
+    REQUIRE(flushed->delta_x == 3);
+    REQUIRE(!coalescer.take());
+
+    /* Nothing is left for the frame, which ends the waiting */
+    REQUIRE(!coalescer.frame());
+    REQUIRE(!coalescer.is_waiting_frame());
+}
+
+TEST_CASE("Motion of different devices is not folded")
+{
+    wf::motion_coalescer_t coalescer;
+    int mouse = 0, touchpad = 0;
+
+    coalescer.add(motion(&mouse, 1, 1, 1));
+    REQUIRE(!coalescer.add(motion(&mouse, 2, 1, 1)));
+
+    auto now = coalescer.add(motion(&touchpad, 3, 5, 5));
+    REQUIRE(now);
+    REQUIRE(now->device == &mouse);
+    REQUIRE(now->delta_x == 1);
+
+    auto flushed = coalescer.frame();
+    REQUIRE(flushed);
+    REQUIRE(flushed->device == &touchpad);
+    REQUIRE(flushed->delta_x == 5);
+    REQUIRE(coalescer.get_stats().folded == 0);
+}
+
+TEST_CASE("Reset stops waiting for a frame")
+{
+    wf::motion_coalescer_t coalescer;
+    int device = 0;
+
+    coalescer.add(motion(&device, 1, 1, 1));
+    coalescer.add(motion(&device, 2, 1, 1));
+    coalescer.reset();
+
+    REQUIRE(!coalescer.is_waiting_frame());
+    REQUIRE(!coalescer.take());
+    REQUIRE(coalescer.add(motion(&device, 3, 1, 1)));
+}
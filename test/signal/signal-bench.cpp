@@ -0,0 +1,50 @@
+/*
+ * Compares emitting signals by name with emitting them by interned
+ * signal_id_t, for signals with and without connections.
+ */
+#include <wayfire/object.hpp>
+#include <iostream>
+#include <string>
+#include "../bench.hpp"
+#include "../mock.hpp"
+
+namespace
+{
+struct provider_t : public wf::signal_provider_t
+{};
+}
+
+int main(int argc, char **argv)
+{
+    const int count = bench_get_count(argc, argv, 1000000);
+    mock_loop::get().start(0);
+
+    /* A provider with as many connected signals as the core typically has */
+    provider_t provider;
+    int calls = 0;
+    wf::signal_connection_t connection{[&] (wf::signal_data_t*) { ++calls; }};
+    for (int i = 0; i < 40; i++)
+    {
+        provider.connect_signal("bench-signal-" + std::to_string(i),
+            &connection);
+    }
+
+    wf::signal_data_t data;
+    const wf::signal_id_t connected_id{"bench-signal-7"};
+    const wf::signal_id_t unconnected_id{"bench-signal-unconnected"};
+
+    std::cout << "connected signal:" << std::endl;
+    measure("by name", count,
+        [&] { provider.emit_signal("bench-signal-7", &data); }, "ns/emit");
+    measure("by id", count,
+        [&] { provider.emit_signal(connected_id, &data); }, "ns/emit");
+
+    std::cout << "signal without connections:" << std::endl;
+    measure("by name", count,
+        [&] { provider.emit_signal("bench-signal-unconnected", &data); },
+        "ns/emit");
+    measure("by id", count,
+        [&] { provider.emit_signal(unconnected_id, &data); }, "ns/emit");
+
+    return (calls == 2 * count) ? 0 : 1;
+}
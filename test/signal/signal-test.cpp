@@ -0,0 +1,80 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <wayfire/object.hpp>
+#include "../mock.hpp"
+
+namespace
+{
+struct provider_t : public wf::signal_provider_t
+{};
+
+struct test_signal_t : public wf::signal_data_t
+{
+    int value = 0;
+};
+}
+
+TEST_CASE("Signal ids are interned")
+{
+    wf::signal_id_t a{"test-signal-a"};
+    wf::signal_id_t a2{"test-signal-a"};
+    wf::signal_id_t b{"test-signal-b"};
+
+    REQUIRE(a == a2);
+    REQUIRE(a != b);
+    REQUIRE(a.get_name() == "test-signal-a");
+    REQUIRE(b.get_name() == "test-signal-b");
+}
+
+TEST_CASE("Signals connected by name are emitted by id and vice versa")
+{
+    mock_loop::get().start(0);
+
+    provider_t provider;
+    int by_name = 0, by_id = 0;
+    wf::signal_connection_t name_conn{[&] (wf::signal_data_t*) { ++by_name; }};
+    wf::signal_connection_t id_conn{[&] (wf::signal_data_t*) { ++by_id; }};
+
+    wf::signal_id_t id{"test-signal-interop"};
+    provider.connect_signal("test-signal-interop", &name_conn);
+    provider.connect_signal(id, &id_conn);
+
+    provider.emit_signal(id, nullptr);
+    REQUIRE(by_name == 1);
+    REQUIRE(by_id == 1);
+
+    provider.emit_signal("test-signal-interop", nullptr);
+    REQUIRE(by_name == 2);
+    REQUIRE(by_id == 2);
+
+    /* Unknown names are not registered by emitting them */
+    provider.emit_signal("test-signal-nobody-listens", nullptr);
+
+    provider.disconnect_signal(&name_conn);
+    mock_loop::get().dispatch_idle();
+    provider.emit_signal(id, nullptr);
+    REQUIRE(by_name == 2);
+    REQUIRE(by_id == 3);
+}
+
+TEST_CASE("Typed signal ids")
+{
+    mock_loop::get().start(0);
+
+    provider_t provider;
+    int received = 0;
+    wf::signal_connection_t conn;
+    conn.set_callback([&] (wf::signal_data_t *data)
+    {
+        received = static_cast<test_signal_t*>(data)->value;
+    });
+
+    wf::typed_signal_id_t<test_signal_t> id{"test-signal-typed"};
+    provider.connect_signal(id, &conn);
+
+    test_signal_t data;
+    data.value = 42;
+    provider.emit_signal(id, &data);
+    REQUIRE(received == 42);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <wayfire/surface.hpp>
+#include <memory>
+#include <vector>
+
+/** A surface without contents, with a given size and position */
+class mock_surface_t : public wf::surface_interface_t
+{
+  public:
+    bool mapped = true;
+    wf::point_t offset = {0, 0};
+    wf::dimensions_t size = {100, 100};
+
+    /** The subsurfaces added with add_child(), from the topmost */
+    std::vector<mock_surface_t*> children_above;
+    std::vector<mock_surface_t*> children_below;
+
+    mock_surface_t(wf::point_t offset = {0, 0}) : offset(offset)
+    {}
+
+    mock_surface_t *add_child(wf::point_t offset, bool below = false)
+    {
+        auto child = std::make_unique<mock_surface_t>(offset);
+        auto ptr   = child.get();
+        auto& list = below ? children_below : children_above;
+        list.insert(list.begin(), ptr);
+        add_subsurface(std::move(child), below);
+        return ptr;
+    }
+
+    bool is_mapped() const override
+    {
+        return mapped;
+    }
+
+    wf::point_t get_offset() override
+    {
+        return offset;
+    }
+
+    wf::dimensions_t get_size() const override
+    {
+        return size;
+    }
+
+    void simple_render(const wf::framebuffer_t&, int, int,
+        const wf::region_t&) override
+    {}
+};
@@ -0,0 +1,84 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "view/snapshot-cache.hpp"
+#include <algorithm>
+#include <cstdint>
+
+using entry_t = wf::snapshot_cache_t::usage_entry_t;
+
+static constexpr size_t MiB = 1024 * 1024;
+
+static wf::view_interface_t *view(int id)
+{
+    return reinterpret_cast<wf::view_interface_t*>((uintptr_t)id * 16);
+}
+
+static wf::output_t *output(int id)
+{
+    return reinterpret_cast<wf::output_t*>((uintptr_t)id * 16);
+}
+
+static bool contains(const std::vector<wf::view_interface_t*>& list, int id)
+{
+    return std::find(list.begin(), list.end(), view(id)) != list.end();
+}
+
+TEST_CASE("Buffers within the budget are kept until they become idle")
+{
+    std::vector<entry_t> entries = {
+        {view(1), output(1), 64 * MiB, 1, 1},
+        {view(2), output(1), 64 * MiB, 2, 3},
+        {view(3), output(1), 64 * MiB, 3, 4},
+        /* Idle frames of other outputs are counted by their own frames */
+        {view(4), output(2), 64 * MiB, 4, 4},
+    };
+
+    auto evicted = wf::snapshot_cache_t::choose_evictions(entries, output(1),
+        256 * MiB, 3);
+    REQUIRE(evicted.size() == 1);
+    REQUIRE(contains(evicted, 3));
+}
+
+TEST_CASE("Buffers used in the current frame are kept over the budget")
+{
+    /* Several large views rendered in every frame, e.g. in scale */
+    std::vector<entry_t> entries;
+    for (int i = 1; i <= 8; i++)
+    {
+        entries.push_back({view(i), output(1), 64 * MiB, (uint64_t)i, 1});
+    }
+
+    auto evicted = wf::snapshot_cache_t::choose_evictions(entries, output(1),
+        256 * MiB, 3);
+    REQUIRE(evicted.empty());
+
+    /* Views of another output, used in its current frame, are kept too */
+    for (auto& entry : entries)
+    {
+        entry.output = output(2);
+        entry.idle_frames = 0;
+    }
+
+    evicted = wf::snapshot_cache_t::choose_evictions(entries, output(1),
+        256 * MiB, 3);
+    REQUIRE(evicted.empty());
+}
+
+TEST_CASE("Least recently used buffers are freed until the budget is met")
+{
+    std::vector<entry_t> entries = {
+        {view(1), output(1), 128 * MiB, 5, 1},
+        {view(2), output(1), 128 * MiB, 1, 2},
+        {view(3), output(2), 128 * MiB, 2, 1},
+        {view(4), output(1), 128 * MiB, 3, 2},
+        {view(5), output(2), 128 * MiB, 4, 0},
+    };
+
+    auto evicted = wf::snapshot_cache_t::choose_evictions(entries, output(1),
+        256 * MiB, 3);
+    REQUIRE(evicted.size() == 3);
+    REQUIRE(contains(evicted, 2));
+    REQUIRE(contains(evicted, 3));
+    REQUIRE(contains(evicted, 4));
+}
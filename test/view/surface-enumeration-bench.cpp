@@ -0,0 +1,100 @@
+/*
+ * Compares the enumeration of deep and wide subsurface trees by concatenating
+ * the lists of all subtrees, as enumerate_surfaces() used to do, with
+ * enumerate_surfaces(), collect_surfaces() into a reused list and
+ * for_each_surface().
+ */
+#include "mock-surface.hpp"
+#include <iostream>
+#include <vector>
+#include "../bench.hpp"
+
+/** Enumerate the surfaces by concatenating the lists of the subtrees */
+static std::vector<wf::surface_iterator_t> enumerate_concat(
+    mock_surface_t *surface, wf::point_t origin)
+{
+    std::vector<wf::surface_iterator_t> result;
+    auto add_children = [&] (const std::vector<mock_surface_t*>& children)
+    {
+        for (auto& child : children)
+        {
+            auto child_surfaces =
+                enumerate_concat(child, child->get_offset() + origin);
+            result.insert(result.end(),
+                child_surfaces.begin(), child_surfaces.end());
+        }
+    };
+
+    add_children(surface->children_above);
+    result.push_back({surface, origin});
+    add_children(surface->children_below);
+    return result;
+}
+
+/** Add depth levels of subsurfaces, with fanout subsurfaces per surface */
+static void build_tree(mock_surface_t *surface, int depth, int fanout)
+{
+    if (depth == 0)
+    {
+        return;
+    }
+
+    for (int i = 0; i < fanout; i++)
+    {
+        build_tree(surface->add_child({i, 1}, i % 2), depth - 1, fanout);
+    }
+}
+
+static void bench(int count, int depth, int fanout)
+{
+    mock_surface_t root;
+    build_tree(&root, depth, fanout);
+
+    size_t nr_surfaces = root.enumerate_surfaces().size();
+    std::cout << "depth " << depth << ", fanout " << fanout << " (" <<
+        nr_surfaces << " surfaces):" << std::endl;
+
+    size_t visited = 0;
+    measure("concatenated lists", count, [&] ()
+    {
+        visited += enumerate_concat(&root, {0, 0}).size();
+    });
+
+    measure("enumerate_surfaces", count, [&] ()
+    {
+        visited += root.enumerate_surfaces().size();
+    });
+
+    std::vector<wf::surface_iterator_t> list;
+    measure("collect_surfaces, reused list", count, [&] ()
+    {
+        list.clear();
+        root.collect_surfaces(list);
+        visited += list.size();
+    });
+
+    measure("for_each_surface", count, [&] ()
+    {
+        root.for_each_surface([&] (const wf::surface_iterator_t&)
+        {
+            ++visited;
+        });
+    });
+
+    /* Keep the compiler from dropping the enumerations */
+    if (visited != 4 * nr_surfaces * count)
+    {
+        std::cout << "  mismatch between the enumerations" << std::endl;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int count = bench_get_count(argc, argv, 10000);
+    bench(count, 1, 1);
+    bench(count, 8, 1);
+    bench(count, 64, 1);
+    bench(count, 4, 4);
+    bench(count, 8, 2);
+    return 0;
+}
@@ -0,0 +1,89 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "mock-surface.hpp"
+
+static std::vector<wf::surface_iterator_t> visit_all(
+    mock_surface_t& root, wf::point_t origin)
+{
+    std::vector<wf::surface_iterator_t> result;
+    root.for_each_surface([&] (const wf::surface_iterator_t& child)
+    {
+        result.push_back(child);
+    }, origin);
+
+    return result;
+}
+
+static void require_same(const std::vector<wf::surface_iterator_t>& a,
+    const std::vector<wf::surface_iterator_t>& b)
+{
+    REQUIRE(a.size() == b.size());
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        REQUIRE(a[i].surface == b[i].surface);
+        REQUIRE(a[i].position == b[i].position);
+    }
+}
+
+TEST_CASE("Surfaces are visited from the topmost to the bottommost")
+{
+    mock_surface_t root;
+    auto above  = root.add_child({10, 0});
+    auto top    = root.add_child({20, 0});
+    auto below  = root.add_child({0, 10}, true);
+    auto nested = above->add_child({1, 1});
+    auto hidden = top->add_child({5, 5});
+    hidden->mapped = false;
+    hidden->add_child({1, 1});
+
+    auto visited = visit_all(root, {100, 200});
+    REQUIRE(visited.size() == 5);
+    REQUIRE(visited[0].surface == top);
+    REQUIRE(visited[0].position == wf::point_t{120, 200});
+    REQUIRE(visited[1].surface == nested);
+    REQUIRE(visited[1].position == wf::point_t{111, 201});
+    REQUIRE(visited[2].surface == above);
+    REQUIRE(visited[3].surface == &root);
+    REQUIRE(visited[3].position == wf::point_t{100, 200});
+    REQUIRE(visited[4].surface == below);
+    REQUIRE(visited[4].position == wf::point_t{100, 210});
+
+    require_same(visited, root.enumerate_surfaces({100, 200}));
+}
+
+TEST_CASE("An unmapped root still has its mapped subsurfaces visited")
+{
+    mock_surface_t root;
+    root.mapped = false;
+    auto child = root.add_child({10, 10});
+
+    auto visited = visit_all(root, {0, 0});
+    REQUIRE(visited.size() == 1);
+    REQUIRE(visited[0].surface == child);
+    require_same(visited, root.enumerate_surfaces());
+}
+
+TEST_CASE("collect_surfaces appends to the list and reuses its memory")
+{
+    mock_surface_t root;
+    auto surface = &root;
+    for (int i = 0; i < 64; i++)
+    {
+        surface = surface->add_child({1, 1}, i % 2);
+    }
+
+    std::vector<wf::surface_iterator_t> list;
+    list.push_back({nullptr, {0, 0}});
+    root.collect_surfaces(list);
+    REQUIRE(list.size() == 66);
+    REQUIRE(list[0].surface == nullptr);
+    list.erase(list.begin());
+    require_same(list, root.enumerate_surfaces());
+
+    auto data = list.data();
+    list.clear();
+    root.collect_surfaces(list);
+    REQUIRE(list.size() == 65);
+    REQUIRE(list.data() == data);
+}